@@ -150,6 +150,7 @@ Settings config = {
 
     /** Benchmarks */
     .benchmark_ui = FALSE,
+    .benchmark_replay = NULL,
 
     /** normalize match */
     .normalize_match = FALSE,
@@ -158,7 +159,9 @@ Settings config = {
     /** fallback icon */
     .application_fallback_icon = NULL,
     /** refilter limit in ms*/
-    .refilter_timeout_limit = 300,
+    .refilter_timeout_limit = 25,
+    /** rows per filter thread */
+    .filter_rows_per_thread = 500,
     /** workaround for broken xserver (#300 on xserver, #611) */
     .xserver_i300_workaround = FALSE,
     /** What browser to use for completion */
@@ -49,6 +49,42 @@ PangoAttrList *helper_token_match_get_pango_attr(RofiHighlightColorStyle th,
                                                  const char *input,
                                                  PangoAttrList *retv);
 
+/**
+ * A matched range of the input, in bytes.
+ */
+typedef struct {
+  /** Start of the match. */
+  int start;
+  /** End of the match. */
+  int end;
+} RofiMatchSpan;
+
+/**
+ * @param tokens Array of regexes used for matching
+ * @param input The input string to find the matches on
+ *
+ * Find the ranges of input that helper_token_match_get_pango_attr() would
+ * highlight, so they can be kept and highlighted again without matching.
+ *
+ * @returns a new array of #RofiMatchSpan.
+ */
+GArray *helper_token_match_get_spans(rofi_int_matcher **tokens,
+                                     const char *input);
+
+/**
+ * @param th The RofiHighlightColorStyle
+ * @param spans The array of #RofiMatchSpan to highlight.
+ * @param retv The Attribute list to update
+ *
+ * Creates a set of pango attributes highlighting the spans.
+ *
+ * @returns the updated retv list.
+ */
+PangoAttrList *
+helper_token_match_spans_to_pango_attr(RofiHighlightColorStyle th,
+                                       const GArray *spans,
+                                       PangoAttrList *retv);
+
 /**
  * @param retv The Attribute list to update with matches
  * @param start The start to highlighting.
@@ -137,6 +137,259 @@ int find_arg(const char *const key);
  * @returns TRUE when matches, FALSE otherwise
  */
 int helper_token_match(rofi_int_matcher *const *tokens, const char *input);
+
+/**
+ * @param tokens  List of (input) tokens to match.
+ * @param input   The entry to match against.
+ * @param len     The length of input in bytes, or -1 if NUL terminated.
+ *
+ * Like helper_token_match(), for input that is not NUL terminated.
+ *
+ * @returns TRUE when matches, FALSE otherwise
+ */
+int helper_token_match_len(rofi_int_matcher *const *tokens, const char *input,
+                           gssize len);
+
+/**
+ * @param str The string to fold.
+ *
+ * Lower-case str one character at a time, the same way case insensitive
+ * matchers lower-case their needle.
+ *
+ * @returns a newly allocated folded string.
+ */
+char *helper_string_fold(const char *str);
+
+/**
+ * Cache of the prepared form of the matchable fields of a mode.
+ * With -normalize-match each field is normalized (and case-folded when not
+ * case sensitive) once, instead of on every match.
+ */
+typedef struct _RofiHaystackCache RofiHaystackCache;
+
+/**
+ * @param num_fields Number of matchable fields per row.
+ *
+ * @returns a new, empty, haystack cache.
+ */
+RofiHaystackCache *helper_haystack_cache_new(unsigned int num_fields);
+
+/**
+ * @param cache The haystack cache (or NULL).
+ * @param num_rows The new number of rows.
+ *
+ * Grow (or shrink) the cache. Prepared rows below num_rows are kept.
+ * Must not be called while rows are being matched.
+ */
+void helper_haystack_cache_resize(RofiHaystackCache *cache,
+                                  unsigned int num_rows);
+
+/**
+ * @param cache The haystack cache (or NULL).
+ *
+ * Free the cache and all prepared fields.
+ */
+void helper_haystack_cache_free(RofiHaystackCache *cache);
+
+/**
+ * @param tokens List of (input) tokens to match.
+ * @param cache The haystack cache (or NULL).
+ * @param row The row input belongs to.
+ * @param field The field of the row input belongs to.
+ * @param input The entry to match against.
+ * @param len The length of input in bytes, or -1 if NUL terminated.
+ *
+ * Like helper_token_match(), but with -normalize-match the normalized input
+ * is taken from (or stored in) the cache. Safe to call from several threads
+ * at once, also for the same row.
+ *
+ * @returns TRUE when matches, FALSE otherwise
+ */
+int helper_token_match_cached(rofi_int_matcher *const *tokens,
+                              RofiHaystackCache *cache, unsigned int row,
+                              unsigned int field, const char *input,
+                              gssize len);
+
+/**
+ * Builder for #ModeColumns, used by modes to export their matchable fields.
+ * The strings are not copied, they have to outlive the store.
+ */
+typedef struct _RofiColumnStore RofiColumnStore;
+
+/**
+ * @param num_columns Number of columns.
+ *
+ * @returns a new, empty, column store.
+ */
+RofiColumnStore *helper_column_store_new(unsigned int num_columns);
+
+/**
+ * @param store The column store.
+ *
+ * Add a row, all its columns are unset.
+ *
+ * @returns the index of the new row.
+ */
+unsigned int helper_column_store_add_row(RofiColumnStore *store);
+
+/**
+ * @param store The column store.
+ * @param row The row to set.
+ * @param column The column to set.
+ * @param value The value (or NULL to unset), kept until the store is freed.
+ * @param len The length of value in bytes, or -1 if NUL terminated.
+ *
+ * Set the value of a column of a row.
+ */
+void helper_column_store_set(RofiColumnStore *store, unsigned int row,
+                             unsigned int column, const char *value,
+                             gssize len);
+
+/**
+ * @param store The column store.
+ *
+ * @returns the number of rows in the store.
+ */
+unsigned int helper_column_store_get_num_rows(const RofiColumnStore *store);
+
+/**
+ * @param store The column store.
+ *
+ * Get the columns. They stay valid until the next change of the store.
+ *
+ * @returns an array with the columns of the store.
+ */
+const ModeColumn *helper_column_store_get_columns(RofiColumnStore *store);
+
+/**
+ * @param store The column store (or NULL).
+ *
+ * Free the store, the strings it points to are not freed.
+ */
+void helper_column_store_free(RofiColumnStore *store);
+
+/**
+ * Append-only storage for many small strings. Strings are copied into large
+ * chunks, that are never moved, and are all freed at once.
+ */
+typedef struct _RofiStringArena RofiStringArena;
+
+/**
+ * @returns a new, empty, string arena.
+ */
+RofiStringArena *helper_string_arena_new(void);
+
+/**
+ * @param arena The string arena.
+ * @param str The string to copy.
+ * @param len The length of str in bytes, or -1 if NUL terminated.
+ *
+ * Copy str into the arena and NUL terminate it. One thread at a time may add
+ * strings, the strings already added can be read from any thread.
+ *
+ * @returns the copy, valid until the arena is freed.
+ */
+char *helper_string_arena_add(RofiStringArena *arena, const char *str,
+                              gssize len);
+
+/**
+ * @param arena The string arena.
+ * @param data The unvalidated character array holding possible UTF-8 data.
+ * @param len The length of data in bytes.
+ *
+ * Like helper_string_arena_add(), but invalid UTF-8 is replaced like
+ * rofi_force_utf8() does.
+ *
+ * @returns the copy, valid until the arena is freed.
+ */
+char *helper_string_arena_add_utf8(RofiStringArena *arena, const char *data,
+                                   gsize len);
+
+/**
+ * @param arena The string arena.
+ * @param other The string arena to merge into arena, freed.
+ *
+ * Move the strings of other into arena, without copying them. The strings
+ * stay valid until arena is freed. Used to fill arenas from several threads.
+ */
+void helper_string_arena_merge(RofiStringArena *arena,
+                               RofiStringArena *other);
+
+/**
+ * @param arena The string arena.
+ *
+ * @returns the number of bytes allocated by the arena.
+ */
+gsize helper_string_arena_get_size(const RofiStringArena *arena);
+
+/**
+ * @param arena The string arena (or NULL).
+ *
+ * Free the arena and all its strings.
+ */
+void helper_string_arena_free(RofiStringArena *arena);
+
+/**
+ * @param tokens List of (input) tokens to match.
+ * @param columns The columns to match against.
+ * @param row The row to match.
+ *
+ * Tokenized match against all columns of row. A token matches if it matches
+ * any of the columns, an inverted token if it matches none of them.
+ *
+ * @returns TRUE when matches, FALSE otherwise
+ */
+int helper_token_match_columns(rofi_int_matcher *const *tokens,
+                               const ModeColumns *columns, unsigned int row);
+
+/**
+ * @param budget Maximum memory use of the index in bytes.
+ *
+ * Create an index of the trigrams (3 byte sequences) in the rows of a mode,
+ * to find the rows that can match a query without testing all of them.
+ * When the index grows beyond budget it is dropped, and queries fall back to
+ * all rows.
+ *
+ * @returns a new, empty, trigram index.
+ */
+RofiTrigramIndex *helper_trigram_index_new(gsize budget);
+
+/**
+ * @param index The trigram index.
+ * @param row The row the text belongs to.
+ * @param text The text to index (or NULL).
+ * @param len The length of text in bytes, or -1 if NUL terminated.
+ *
+ * Add text of row to the index. Rows are added in ascending order, a row can
+ * be added more than once for each of its fields. Thread safe.
+ */
+void helper_trigram_index_add(RofiTrigramIndex *index, unsigned int row,
+                              const char *text, gssize len);
+
+/**
+ * @param index The trigram index (or NULL).
+ *
+ * Free the index.
+ */
+void helper_trigram_index_free(RofiTrigramIndex *index);
+
+/**
+ * @param index The trigram index.
+ * @param tokens List of (input) tokens to match.
+ * @param num_rows Number of rows to consider.
+ * @param length Set to the number of candidate rows.
+ *
+ * Find the rows below num_rows that can match tokens. Only non-inverted
+ * normal, prefix and glob tokens with a literal of 3 or more bytes narrow the
+ * result, other tokens still have to be tested on each candidate.
+ *
+ * @returns the sorted candidate rows (free with g_free), or NULL if the index
+ * cannot narrow the query and all rows are candidates.
+ */
+unsigned int *helper_trigram_index_query(RofiTrigramIndex *index,
+                                         rofi_int_matcher *const *tokens,
+                                         unsigned int num_rows,
+                                         unsigned int *length);
 /**
  * @param cmd The command to execute.
  *
@@ -208,6 +461,48 @@ char *rofi_expand_path(const char *input);
 unsigned int levenshtein(const char *needle, const glong needlelen,
                          const char *haystack, const glong haystacklen);
 
+/**
+ * A needle prepared for bit-parallel levenshtein distance calculation.
+ */
+typedef struct _RofiLevenshteinNeedle RofiLevenshteinNeedle;
+
+/**
+ * @param needle The string to find match weight off
+ * @param needlelen The length of the needle
+ *
+ * Decode and case-fold (unless case sensitive) the needle once, so it can be
+ * compared against many haystacks.
+ *
+ * @returns the prepared needle, free with levenshtein_needle_free().
+ */
+RofiLevenshteinNeedle *levenshtein_needle_new(const char *needle,
+                                              const glong needlelen);
+
+/**
+ * @param n The prepared needle to free (or NULL).
+ *
+ * Free the prepared needle.
+ */
+void levenshtein_needle_free(RofiLevenshteinNeedle *n);
+
+/**
+ * @param n The prepared needle.
+ * @param haystack The string to match against
+ * @param haystacklen The length of the haystack in characters, or -1 if NUL
+ * terminated.
+ * @param bound Stop once the distance is known to be larger than bound.
+ *
+ * Bit-parallel levenshtein distance, needles longer than 64 characters are
+ * split over multiple words.
+ *
+ * @returns the levenshtein distance between needle and haystack, or bound + 1
+ * if it is larger than bound.
+ */
+unsigned int levenshtein_needle_distance(const RofiLevenshteinNeedle *n,
+                                         const char *haystack,
+                                         const glong haystacklen,
+                                         unsigned int bound);
+
 /**
  * @param data the unvalidated character array holding possible UTF-8 data
  * @param length the length of the data array
@@ -374,6 +669,20 @@ void parse_ranges(char *input, rofi_range_pair **list, unsigned int *length);
 void rofi_output_formatted_line(const char *format, const char *string,
                                 int selected_line, const char *filter);
 
+/**
+ * @param format The format string used, see rofi_output_formatted_line().
+ * @param string The selected entry.
+ * @param selected_line The selected line index.
+ * @param filter The entered filter.
+ *
+ * Like rofi_output_formatted_line(), but stdout is not flushed. For output of
+ * many lines at once.
+ */
+void rofi_output_formatted_line_buffered(const char *format,
+                                         const char *string,
+                                         int selected_line,
+                                         const char *filter);
+
 /**
  * @param string The string with elements to be replaced
  * @param ...    Set of {key}, value that will be replaced, terminated by  a
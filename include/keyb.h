@@ -198,5 +198,11 @@ void abe_list_all_bindings(gboolean is_term);
  * @returns id, or UINT32_MAX if not found.
  */
 guint key_binding_get_action_from_name(const char *name);
+/**
+ * @param name The name of the binding.
+ *
+ * @returns the scope the binding is triggered in, SCOPE_GLOBAL if not found.
+ */
+BindingsScope key_binding_get_scope_from_name(const char *name);
 /**@}*/
 #endif // ROFI_KEYB_H
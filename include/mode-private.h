@@ -32,7 +32,9 @@
 G_BEGIN_DECLS
 
 /** ABI version to check if loaded plugin is compatible. */
-#define ABI_VERSION 7u
+#define ABI_VERSION 8u
+/** Oldest ABI version of a plugin that can still be loaded. */
+#define ABI_VERSION_MIN 7u
 
 /**
  * Indicator what type of mode this is.
@@ -96,6 +98,19 @@ typedef cairo_surface_t *(*_mode_get_icon)(const Mode *sw,
 typedef char *(*_mode_get_completion)(const Mode *sw,
                                       unsigned int selected_line);
 
+/**
+ * @param sw The #Mode pointer
+ * @param selected_line The selected line
+ *
+ * Obtains the string to complete, without copying it. Can be called from
+ * the filter workers.
+ *
+ * @return the completion string owned by the mode, or NULL if it needs to be
+ * created by _get_completion.
+ */
+typedef const char *(*_mode_peek_completion)(const Mode *sw,
+                                             unsigned int selected_line);
+
 /**
  * @param data The #Mode pointer
  * @param tokens  List of (input) tokens to match.
@@ -189,6 +204,17 @@ typedef ModeMode (*_mode_completer_result)(Mode *sw, int menu_retv,
                                            char **input,
                                            unsigned int selected_line,
                                            char **path);
+/**
+ * @param sw The #Mode pointer
+ * @param columns The columns to fill [out]
+ *
+ * Export the matchable fields of all rows, so they can be matched without a
+ * callback per row. The columns stay valid until the mode changes its rows.
+ *
+ * @returns TRUE if columns is filled, FALSE to match using _token_match.
+ */
+typedef gboolean (*_mode_get_columns)(const Mode *sw, ModeColumns *columns);
+
 /**
  * Structure defining a switcher.
  * It consists of a name, callback and if enabled
@@ -258,6 +284,11 @@ struct rofi_mode {
 
   /** type */
   ModeType type;
+
+  /** Get the matchable fields as columns (optional, ABI version 8). */
+  _mode_get_columns _get_columns;
+  /** Get the 'completed' entry without copying (optional, ABI version 8). */
+  _mode_peek_completion _peek_completion;
 };
 G_END_DECLS
 #endif // ROFI_MODE_PRIVATE_H
@@ -152,6 +152,18 @@ cairo_surface_t *mode_get_icon(Mode *mode, unsigned int selected_line,
  */
 char *mode_get_completion(const Mode *mode, unsigned int selected_line);
 
+/**
+ * @param mode The mode to query
+ * @param selected_line The entry to query
+ *
+ * Like mode_get_completion(), but returns the string owned by the mode.
+ * It stays valid until the mode changes its rows.
+ *
+ * @returns the completion string, or NULL if the mode can not provide it
+ * without allocating (use mode_get_completion()).
+ */
+const char *mode_peek_completion(const Mode *mode, unsigned int selected_line);
+
 /**
  * @param mode The mode to query
  * @param menu_retv The menu return value.
@@ -177,6 +189,19 @@ ModeMode mode_result(Mode *mode, int menu_retv, char **input,
 int mode_token_match(const Mode *mode, rofi_int_matcher **tokens,
                      unsigned int selected_line);
 
+/**
+ * @param mode The mode to query
+ * @param columns The columns to fill [out]
+ *
+ * Get the matchable fields of all rows as columns, if the mode provides them.
+ * Call from the main thread; the columns stay valid until the mode changes
+ * its rows.
+ *
+ * @returns TRUE if columns is filled, FALSE if rows should be matched with
+ * mode_token_match().
+ */
+gboolean mode_get_columns(const Mode *mode, ModeColumns *columns);
+
 /**
  * @param mode The mode to query
  *
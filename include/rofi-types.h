@@ -362,8 +362,59 @@ typedef struct rofi_range_pair {
 typedef struct rofi_int_matcher_t {
   GRegex *regex;
   gboolean invert;
+  /**
+   * Native matching function, if NULL the regex is used.
+   * The input has a length of len bytes and is not necessarily NUL
+   * terminated, use len. If folded is set, the input is already lower-cased
+   * (see helper_string_fold).
+   */
+  gboolean (*match)(const struct rofi_int_matcher_t *m, const char *input,
+                    size_t len, gboolean folded);
+  /** The needle, lower-cased when case insensitive. */
+  char *needle;
+  /** Length of needle in bytes. */
+  size_t needle_len;
+  /** The needle decoded into (lower-cased) characters. */
+  gunichar *needle_chars;
+  /** Number of characters in needle_chars. */
+  glong needle_nchars;
+  /** If the match is case sensitive. */
+  gboolean case_sensitive;
+  /** If the needle only contains ASCII characters. */
+  gboolean ascii;
 } rofi_int_matcher;
 
+/** Trigram index over the rows of a mode, see helper_trigram_index_new(). */
+typedef struct _RofiTrigramIndex RofiTrigramIndex;
+
+/**
+ * One field of all rows of a mode. The strings belong to the mode, they are
+ * not necessarily NUL terminated.
+ */
+typedef struct {
+  /** Per row, the string, or NULL if the row has no value. */
+  const char *const *strings;
+  /** Per row, the length of the string in bytes. */
+  const unsigned int *lengths;
+} ModeColumn;
+
+/**
+ * The matchable fields of all rows of a mode, see mode_get_columns().
+ */
+typedef struct {
+  /** Number of rows in each column. */
+  unsigned int num_rows;
+  /** Number of columns to match against. */
+  unsigned int num_columns;
+  /** The columns to match against, a row matches a token if any column
+   * does. */
+  const ModeColumn *columns;
+  /** The string to sort on for each row, strings is NULL if not provided. */
+  ModeColumn completion;
+  /** Trigram index over the columns to find candidate rows, or NULL. */
+  RofiTrigramIndex *index;
+} ModeColumns;
+
 /**
  * Structure with data to process by each worker thread.
  * TODO: Make this more generic wrapper.
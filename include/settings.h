@@ -174,6 +174,8 @@ typedef struct {
 
   /** Benchmark */
   gboolean benchmark_ui;
+  /** Script of input events to replay, measuring the latency. */
+  char *benchmark_replay;
 
   gboolean normalize_match;
   /** Steal focus */
@@ -181,9 +183,11 @@ typedef struct {
   /** fallback icon */
   char *application_fallback_icon;
 
-  /** refilter timeout limit, when more then these entries,go into timeout mode.
-   */
+  /** Time (in ms) filtering may block input, after this it continues in the
+   * background. */
   unsigned int refilter_timeout_limit;
+  /** Rows per thread used to filter, smaller inputs use fewer threads. */
+  unsigned int filter_rows_per_thread;
 
   /** workaround for broken xserver (#300 on xserver, #611) */
   gboolean xserver_i300_workaround;
@@ -33,6 +33,15 @@
 #ifndef ROFI_TIMINGS_H
 #define ROFI_TIMINGS_H
 
+#include <glib.h>
+
+/**
+ * If a trace is recorded, see rofi_timings_trace_enable().
+ * Workers read it while the main thread sets it, only access it with
+ * g_atomic_int_get() and g_atomic_int_set().
+ */
+extern gint rofi_timings_trace;
+
 /**
  * Init the timestamping mechanism .
  * implementation.
@@ -53,6 +62,31 @@ void rofi_timings_tick(const char *file, char const *str, int line,
  */
 void rofi_timings_quit(void);
 
+/**
+ * @param path The file to write the trace to.
+ *
+ * Record a trace of the ticks and spans, in the Chrome trace event format.
+ * The trace is written to path by rofi_timings_quit(). Call from the main
+ * thread.
+ */
+void rofi_timings_trace_enable(const char *path);
+
+/**
+ * @param name The name of the span, has to stay valid until
+ * rofi_timings_quit().
+ *
+ * Begin a span on the calling thread.
+ */
+void rofi_timings_trace_begin(const char *name);
+
+/**
+ * @param name The name of the span, has to stay valid until
+ * rofi_timings_quit().
+ *
+ * End the last span begun on the calling thread.
+ */
+void rofi_timings_trace_end(const char *name);
+
 /**
  * Start timestamping mechanism.
  * Call to this function is time 0.
@@ -71,6 +105,28 @@ void rofi_timings_quit(void);
  * Stop timestamping mechanism.
  */
 #define TIMINGS_STOP() rofi_timings_quit()
+/**
+ * @param name The name of the span.
+ *
+ * Begin a span in the trace, if a trace is recorded.
+ */
+#define TRACE_BEGIN(name)                                                      \
+  do {                                                                         \
+    if (G_UNLIKELY(g_atomic_int_get(&rofi_timings_trace))) {                   \
+      rofi_timings_trace_begin(name);                                          \
+    }                                                                          \
+  } while (0)
+/**
+ * @param name The name of the span.
+ *
+ * End the span begun with TRACE_BEGIN().
+ */
+#define TRACE_END(name)                                                        \
+  do {                                                                         \
+    if (G_UNLIKELY(g_atomic_int_get(&rofi_timings_trace))) {                   \
+      rofi_timings_trace_end(name);                                            \
+    }                                                                          \
+  } while (0)
 
 #else
 
@@ -92,6 +148,18 @@ void rofi_timings_quit(void);
  * Report current time since TIMINGS_START
  */
 #define TICK_N(a)
+/**
+ * @param name The name of the span.
+ *
+ * Begin a span in the trace.
+ */
+#define TRACE_BEGIN(name)
+/**
+ * @param name The name of the span.
+ *
+ * End the span begun with TRACE_BEGIN().
+ */
+#define TRACE_END(name)
 
 #endif // ROFI_TIMINGS_H
 /**@}*/
@@ -29,6 +29,7 @@
 #define ROFI_VIEW_INTERNAL_H
 #include "keyb.h"
 #include "mode.h"
+#include "settings.h"
 #include "theme.h"
 #include "widgets/box.h"
 #include "widgets/container.h"
@@ -78,6 +79,9 @@ struct RofiViewState {
 
   /** number of (filtered) elements to show. */
   unsigned int filtered_lines;
+  /** number of (filtered) elements at the start of line_map in final order.
+   */
+  unsigned int ranked_lines;
 
   /** Previously called key action. */
   KeyBindingAction prev_action;
@@ -118,6 +122,8 @@ struct RofiViewState {
   int mouse_seen;
   /** Flag indicating if view needs to be reloaded. */
   int reload;
+  /** Flag indicating rows were appended to the mode. */
+  int append;
   /** The function to be called when finalizing this view */
   void (*finalize)(struct RofiViewState *state);
 
@@ -142,6 +148,46 @@ struct RofiViewState {
 
   /** Regexs used for matching */
   rofi_int_matcher **tokens;
+  /** Match spans of drawn rows for the current tokens, keyed on row. */
+  GHashTable *highlight_cache;
+
+  /** Filter pass running in the background, NULL if none. */
+  struct _filter_job *filter_job;
+  /** Generation of the latest filter pass, older results are dropped. */
+  unsigned int filter_generation;
+
+  /** State of the previous filter pass, used to narrow the next one. */
+  struct {
+    /** The raw user input. */
+    char *input;
+    /** The input after mode preprocessing. */
+    char *pattern;
+    /** Case sensitivity the pass was done with. */
+    int case_sensitive;
+    /** If the result was sorted. */
+    unsigned int sort;
+    /** Matching method used. */
+    MatchingMethod matching_method;
+  } prev_filter;
+
+  /** Results of earlier filter passes, most recently used first. */
+  GQueue filter_cache;
+  /** Number of bytes held by filter_cache. */
+  gsize filter_cache_size;
+
+  /** Time (in us) spent in the phases of the last filter pass. */
+  struct {
+    /** Monotonic time the pass started. */
+    gint64 start;
+    /** Matching and scoring rows, until the result is applied. */
+    gint64 filter;
+    /** Ordering the start of the result. */
+    gint64 sort;
+    /** Passing the number of rows to the listview. */
+    gint64 listview;
+    /** Resizing the window to the result. */
+    gint64 resize;
+  } filter_timings;
 };
 /** @} */
 #endif
@@ -96,7 +96,7 @@ MenuReturn rofi_view_get_return_value(const RofiViewState *state);
  *
  * @return the next position.
  */
-unsigned int rofi_view_get_next_position(const RofiViewState *state);
+unsigned int rofi_view_get_next_position(RofiViewState *state);
 /**
  * @param state the Menu handle
  * @param text The text to add to the input box
@@ -263,9 +263,48 @@ void rofi_view_hide(void);
  * This can only be done when *more* information is available.
  *
  * The reloading happens 'lazy', multiple calls might be handled at once.
+ * Calls from other threads are passed on to the main loop.
  */
 void rofi_view_reload(void);
 
+/**
+ * Indicate the rows of the current view have to be drawn again, for example
+ * because an icon finished loading. The rows themselves did not change, so
+ * nothing is filtered again. Can be called from any thread.
+ *
+ * Like rofi_view_reload(), this happens 'lazy'.
+ */
+void rofi_view_redraw_rows(void);
+
+/**
+ * Indicate rows were appended to the mode of the current view, the existing
+ * rows did not change. Only the new rows are filtered and added to the
+ * current result.
+ *
+ * Like rofi_view_reload(), this happens 'lazy'.
+ */
+void rofi_view_append_rows(void);
+
+/**
+ * Complete the filter pass running in the background, if any.
+ * Filtering reads the rows from worker threads, a mode that changes its rows
+ * from the main loop has to call this first.
+ */
+void rofi_view_filter_finish(void);
+
+/**
+ * Pause the filter pass running in the background, if any. Only the rows
+ * workers are busy with are waited for. A mode that only appends rows can
+ * call this instead of rofi_view_filter_finish(), and
+ * rofi_view_filter_resume() once the rows are added.
+ */
+void rofi_view_filter_pause(void);
+
+/**
+ * Continue the filter pass paused with rofi_view_filter_pause().
+ */
+void rofi_view_filter_resume(void);
+
 /**
  * @param state The handle to the view
  * @param mode The new mode to display
@@ -297,6 +336,17 @@ void rofi_view_clear_input(RofiViewState *state);
  */
 void __create_window(MenuFlags menu_flags);
 
+/**
+ * @param menu_flags The state of the new window.
+ * @param width Width of the monitor to lay out the views on.
+ * @param height Height of the monitor to lay out the views on.
+ *
+ * Setup the view without an X11 window, views are laid out and drawn on an
+ * in-memory surface. Use instead of __create_window(), for benchmarks that
+ * run without an X server.
+ */
+void rofi_view_create_headless(MenuFlags menu_flags, int width, int height);
+
 /**
  * Get the handle of the main window.
  *
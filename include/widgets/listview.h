@@ -258,6 +258,15 @@ gboolean listview_get_fixed_num_lines(listview *lv);
  */
 void listview_set_fixed_num_lines(listview *lv);
 
+/**
+ * @param lv Handler to the listview object.
+ *
+ * Get the number of elements that fit in the listview.
+ *
+ * @returns the number of elements.
+ */
+unsigned int listview_get_max_elements(listview *lv);
+
 /**
  * @param lv Handler to the listview object.
  * @param max_lines the maximum number of lines to display.
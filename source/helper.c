@@ -119,6 +119,8 @@ int helper_parse_setup(char *string, char ***output, int *length, ...) {
 void helper_tokenize_free(rofi_int_matcher **tokens) {
   for (size_t i = 0; tokens && tokens[i]; i++) {
     g_regex_unref((GRegex *)tokens[i]->regex);
+    g_free(tokens[i]->needle);
+    g_free(tokens[i]->needle_chars);
     g_free(tokens[i]);
   }
   g_free(tokens);
@@ -199,6 +201,14 @@ static char *utf8_helper_simplify_string(const char *os) {
   return str;
 }
 
+char *helper_string_fold(const char *str) {
+  GString *retv = g_string_sized_new(strlen(str));
+  for (const char *iter = str; *iter != '\0'; iter = g_utf8_next_char(iter)) {
+    g_string_append_unichar(retv, g_unichar_tolower(g_utf8_get_char(iter)));
+  }
+  return g_string_free(retv, FALSE);
+}
+
 // Macro for quickly generating regex for matching.
 static inline GRegex *R(const char *s, int case_sensitive) {
   if (config.normalize_match) {
@@ -215,6 +225,318 @@ static inline GRegex *R(const char *s, int case_sensitive) {
       s, G_REGEX_OPTIMIZE | ((case_sensitive) ? 0 : G_REGEX_CASELESS), 0, NULL);
 }
 
+/** Needle character matching any sequence of characters (glob '*'). */
+#define MATCHER_GLOB_STAR ((gunichar)-1)
+/** Needle character matching any non-space character (glob '?'). */
+#define MATCHER_GLOB_ANY ((gunichar)-2)
+
+/**
+ * @param c The character to check.
+ *
+ * Word characters as used by the regex \\b assertion.
+ *
+ * @returns TRUE if c is a word character.
+ */
+static inline gboolean matcher_is_word(gunichar c) {
+  return c == '_' || g_unichar_isalnum(c);
+}
+
+/**
+ * @param c The character.
+ *
+ * @returns c lower-cased if it is an ASCII upper-case letter.
+ */
+static inline int matcher_ascii_tolower(int c) {
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/**
+ * @param p Pointer to a valid UTF-8 character.
+ *
+ * @returns the character at p, without a call for ASCII.
+ */
+static inline gunichar matcher_get_char(const char *p) {
+  return ((guchar)*p < 0x80) ? (gunichar)*p : g_utf8_get_char(p);
+}
+
+/**
+ * @param cs If the comparison is case sensitive.
+ * @param c The character from the input.
+ * @param nc The (lower-cased) needle character.
+ *
+ * @returns TRUE if the input character matches the needle character.
+ */
+static inline gboolean matcher_char_equal(gboolean cs, gunichar c,
+                                          gunichar nc) {
+  if (c == nc) {
+    return TRUE;
+  }
+  if (cs) {
+    return FALSE;
+  }
+  if (c < 0x80) {
+    return (gunichar)matcher_ascii_tolower(c) == nc;
+  }
+  return g_unichar_tolower(c) == nc;
+}
+
+/**
+ * @param m The matcher.
+ * @param cs If the comparison is case sensitive.
+ * @param p The position in the input.
+ * @param end The end of the input.
+ *
+ * @returns TRUE if the needle characters match at p.
+ */
+static gboolean matcher_chars_match_at(const rofi_int_matcher *m, gboolean cs,
+                                       const char *p, const char *end) {
+  for (glong i = 0; i < m->needle_nchars; i++) {
+    if (p >= end) {
+      return FALSE;
+    }
+    if (!matcher_char_equal(cs, matcher_get_char(p), m->needle_chars[i])) {
+      return FALSE;
+    }
+    p = g_utf8_next_char(p);
+  }
+  return TRUE;
+}
+
+/**
+ * @param m The matcher.
+ * @param cs If the comparison is case sensitive.
+ * @param s Where to start searching.
+ * @param end The end of the input.
+ *
+ * Find the next occurrence of the needle.
+ * For case insensitive ASCII needles the input is scanned with memchr for
+ * both cases of the first byte, then the rest is compared.
+ *
+ * @returns a pointer to the occurrence, or NULL if not found.
+ */
+static const char *matcher_find(const rofi_int_matcher *m, gboolean cs,
+                                const char *s, const char *end) {
+  if (m->needle_len == 0) {
+    return s;
+  }
+  if ((size_t)(end - s) < m->needle_len) {
+    return NULL;
+  }
+  if (cs) {
+    // The input is not NUL terminated at end.
+    return memmem(s, end - s, m->needle, m->needle_len);
+  }
+  if (m->ascii) {
+    // Last position an occurrence can start.
+    const char *last = end - m->needle_len + 1;
+    const char lo = m->needle[0];
+    const char up = g_ascii_toupper(lo);
+    const char *plo = memchr(s, lo, last - s);
+    const char *pup = (lo != up) ? memchr(s, up, last - s) : NULL;
+    while (plo != NULL || pup != NULL) {
+      const char *p = (plo != NULL && (pup == NULL || plo < pup)) ? plo : pup;
+      if (g_ascii_strncasecmp(p + 1, m->needle + 1, m->needle_len - 1) == 0) {
+        return p;
+      }
+      if (p == plo) {
+        plo = memchr(p + 1, lo, last - (p + 1));
+      } else {
+        pup = memchr(p + 1, up, last - (p + 1));
+      }
+    }
+    return NULL;
+  }
+  for (const char *p = s; p < end; p = g_utf8_next_char(p)) {
+    if (matcher_chars_match_at(m, cs, p, end)) {
+      return p;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Substring match (MM_NORMAL).
+ */
+static gboolean matcher_match_normal(const rofi_int_matcher *m,
+                                     const char *input, size_t len,
+                                     gboolean folded) {
+  gboolean cs = m->case_sensitive || folded;
+  return matcher_find(m, cs, input, input + len) != NULL;
+}
+
+/**
+ * Match at the start of a word (MM_PREFIX), like the regex \\bneedle.
+ */
+static gboolean matcher_match_prefix(const rofi_int_matcher *m,
+                                     const char *input, size_t len,
+                                     gboolean folded) {
+  gboolean cs = m->case_sensitive || folded;
+  const char *end = input + len;
+  if (m->needle_nchars == 0) {
+    // Only a word boundary, present when the input has a word character.
+    for (const char *p = input; p < end; p = g_utf8_next_char(p)) {
+      if (matcher_is_word(g_utf8_get_char(p))) {
+        return TRUE;
+      }
+    }
+    return FALSE;
+  }
+  gboolean first_is_word = matcher_is_word(m->needle_chars[0]);
+  for (const char *p = matcher_find(m, cs, input, end); p != NULL;
+       p = matcher_find(m, cs, g_utf8_next_char(p), end)) {
+    gboolean prev_is_word = FALSE;
+    if (p > input) {
+      const char *prev = g_utf8_find_prev_char(input, p);
+      prev_is_word = prev != NULL && matcher_is_word(g_utf8_get_char(prev));
+    }
+    if (prev_is_word != first_is_word) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/**
+ * Subsequence match (MM_FUZZY).
+ */
+static gboolean matcher_match_fuzzy(const rofi_int_matcher *m,
+                                    const char *input, size_t len,
+                                    gboolean folded) {
+  gboolean cs = m->case_sensitive || folded;
+  glong i = 0;
+  if (m->ascii) {
+    const char *needle = m->needle;
+    for (size_t k = 0; k < len && i < m->needle_nchars; k++) {
+      char c = cs ? input[k] : matcher_ascii_tolower(input[k]);
+      if (c == needle[i]) {
+        i++;
+      }
+    }
+    return i == m->needle_nchars;
+  }
+  const char *end = input + len;
+  for (const char *p = input; p < end && i < m->needle_nchars;
+       p = g_utf8_next_char(p)) {
+    if (matcher_char_equal(cs, matcher_get_char(p), m->needle_chars[i])) {
+      i++;
+    }
+  }
+  return i == m->needle_nchars;
+}
+
+/**
+ * Wildcard match (MM_GLOB) anywhere in the input. '*' matches any sequence,
+ * '?' any non-space character.
+ * Greedy match that backtracks to the last star, with an implicit star at
+ * the start and the end of the pattern.
+ */
+static gboolean matcher_match_glob(const rofi_int_matcher *m,
+                                   const char *input, size_t len,
+                                   gboolean folded) {
+  gboolean cs = m->case_sensitive || folded;
+  const char *end = input + len;
+  const gunichar *pat = m->needle_chars;
+  glong np = m->needle_nchars;
+  glong pi = 0;
+  glong star = 0;
+  const char *t = input;
+  const char *star_t = input;
+  while (pi < np) {
+    if (pat[pi] == MATCHER_GLOB_STAR) {
+      star = ++pi;
+      star_t = t;
+      continue;
+    }
+    if (t < end) {
+      gunichar c = matcher_get_char(t);
+      gboolean eq = (pat[pi] == MATCHER_GLOB_ANY)
+                        ? !g_unichar_isspace(c)
+                        : matcher_char_equal(cs, c, pat[pi]);
+      if (eq) {
+        pi++;
+        t = g_utf8_next_char(t);
+        continue;
+      }
+    }
+    if (star_t >= end) {
+      return FALSE;
+    }
+    // Let the last star absorb one more character and retry.
+    star_t = g_utf8_next_char(star_t);
+    if (star == 0 && pat[0] != MATCHER_GLOB_ANY) {
+      // Skip start positions that cannot match the first character. Compare
+      // like above, a non-ASCII character can fold to an ASCII one.
+      while (star_t < end &&
+             !matcher_char_equal(cs, matcher_get_char(star_t), pat[0])) {
+        star_t = g_utf8_next_char(star_t);
+      }
+    }
+    t = star_t;
+    pi = star;
+  }
+  return TRUE;
+}
+
+/**
+ * @param rv The matcher to set up.
+ * @param input The token (after the negate character).
+ * @param case_sensitive If the match is case sensitive.
+ *
+ * Set up the native matcher for the non-regex matching methods.
+ */
+static void create_native_matcher(rofi_int_matcher *rv, const char *input,
+                                  int case_sensitive) {
+  switch (config.matching_method) {
+  case MM_GLOB:
+    rv->match = matcher_match_glob;
+    break;
+  case MM_FUZZY:
+    rv->match = matcher_match_fuzzy;
+    break;
+  case MM_PREFIX:
+    rv->match = matcher_match_prefix;
+    break;
+  case MM_NORMAL:
+    rv->match = matcher_match_normal;
+    break;
+  default:
+    return;
+  }
+  char *needle = config.normalize_match ? utf8_helper_simplify_string(input)
+                                        : g_strdup(input);
+  rv->case_sensitive = case_sensitive;
+  rv->ascii = TRUE;
+  for (const char *iter = needle; *iter != '\0'; iter++) {
+    if ((guchar)*iter >= 0x80) {
+      rv->ascii = FALSE;
+      break;
+    }
+  }
+  rv->needle_chars = g_utf8_to_ucs4_fast(needle, -1, &(rv->needle_nchars));
+  if (case_sensitive) {
+    rv->needle = needle;
+  } else {
+    // Lower-case per character, the same way helper_string_fold does, so the
+    // needle can be compared as-is with folded input.
+    for (glong i = 0; i < rv->needle_nchars; i++) {
+      rv->needle_chars[i] = g_unichar_tolower(rv->needle_chars[i]);
+    }
+    rv->needle =
+        g_ucs4_to_utf8(rv->needle_chars, rv->needle_nchars, NULL, NULL, NULL);
+    g_free(needle);
+  }
+  rv->needle_len = strlen(rv->needle);
+  for (glong i = 0; i < rv->needle_nchars; i++) {
+    if (config.matching_method == MM_GLOB) {
+      if (rv->needle_chars[i] == '*') {
+        rv->needle_chars[i] = MATCHER_GLOB_STAR;
+      } else if (rv->needle_chars[i] == '?') {
+        rv->needle_chars[i] = MATCHER_GLOB_ANY;
+      }
+    }
+  }
+}
+
 static rofi_int_matcher *create_regex(const char *input, int case_sensitive) {
   GRegex *retv = NULL;
   gchar *r;
@@ -254,6 +576,7 @@ static rofi_int_matcher *create_regex(const char *input, int case_sensitive) {
     break;
   }
   rv->regex = retv;
+  create_native_matcher(rv, input, case_sensitive);
   return rv;
 }
 rofi_int_matcher **helper_tokenize(const char *input, int case_sensitive) {
@@ -480,13 +803,12 @@ void helper_token_match_set_pango_attr_on_style(PangoAttrList *retv, int start,
   }
 }
 
-PangoAttrList *helper_token_match_get_pango_attr(RofiHighlightColorStyle th,
-                                                 rofi_int_matcher **tokens,
-                                                 const char *input,
-                                                 PangoAttrList *retv) {
+GArray *helper_token_match_get_spans(rofi_int_matcher **tokens,
+                                     const char *input) {
+  GArray *spans = g_array_new(FALSE, FALSE, sizeof(RofiMatchSpan));
   // Disable highlighting for normalize match, not supported atm.
   if (config.normalize_match) {
-    return retv;
+    return spans;
   }
   // Do a tokenized match.
   if (tokens) {
@@ -499,39 +821,693 @@ PangoAttrList *helper_token_match_get_pango_attr(RofiHighlightColorStyle th,
       while (g_match_info_matches(gmi)) {
         int count = g_match_info_get_match_count(gmi);
         for (int index = (count > 1) ? 1 : 0; index < count; index++) {
-          int start, end;
-          g_match_info_fetch_pos(gmi, index, &start, &end);
-          helper_token_match_set_pango_attr_on_style(retv, start, end, th);
+          RofiMatchSpan span;
+          g_match_info_fetch_pos(gmi, index, &(span.start), &(span.end));
+          g_array_append_val(spans, span);
         }
         g_match_info_next(gmi, NULL);
       }
       g_match_info_free(gmi);
     }
   }
+  return spans;
+}
+
+PangoAttrList *
+helper_token_match_spans_to_pango_attr(RofiHighlightColorStyle th,
+                                       const GArray *spans,
+                                       PangoAttrList *retv) {
+  for (guint i = 0; i < spans->len; i++) {
+    const RofiMatchSpan *span = &g_array_index(spans, RofiMatchSpan, i);
+    helper_token_match_set_pango_attr_on_style(retv, span->start, span->end,
+                                               th);
+  }
+  return retv;
+}
+
+PangoAttrList *helper_token_match_get_pango_attr(RofiHighlightColorStyle th,
+                                                 rofi_int_matcher **tokens,
+                                                 const char *input,
+                                                 PangoAttrList *retv) {
+  GArray *spans = helper_token_match_get_spans(tokens, input);
+  helper_token_match_spans_to_pango_attr(th, spans, retv);
+  g_array_free(spans, TRUE);
   return retv;
 }
 
 int helper_token_match(rofi_int_matcher *const *tokens, const char *input) {
+  return helper_token_match_len(tokens, input, -1);
+}
+
+int helper_token_match_len(rofi_int_matcher *const *tokens, const char *input,
+                           gssize len) {
   int match = TRUE;
   // Do a tokenized match.
   if (tokens) {
+    char *r = NULL;
     if (config.normalize_match) {
-      char *r = utf8_helper_simplify_string(input);
-      for (int j = 0; match && tokens[j]; j++) {
-        match = g_regex_match(tokens[j]->regex, r, 0, NULL);
-        match ^= tokens[j]->invert;
+      char *str = (len < 0) ? (char *)input : g_strndup(input, len);
+      r = utf8_helper_simplify_string(str);
+      if (str != input) {
+        g_free(str);
       }
-      g_free(r);
+      input = r;
+      len = -1;
+    }
+    if (len < 0) {
+      len = strlen(input);
+    }
+    for (int j = 0; match && tokens[j]; j++) {
+      if (tokens[j]->match != NULL) {
+        match = tokens[j]->match(tokens[j], input, len, FALSE);
+      } else {
+        match =
+            g_regex_match_full(tokens[j]->regex, input, len, 0, 0, NULL, NULL);
+      }
+      match ^= tokens[j]->invert;
+    }
+    g_free(r);
+  }
+  return match;
+}
+
+/**
+ * Prepared form of one field of a row, never changed once published.
+ */
+typedef struct {
+  /** Length of text in bytes. */
+  size_t len;
+  /** Normalized (and folded) text. */
+  char text[];
+} RofiHaystackText;
+
+/**
+ * The prepared forms of one field of a row.
+ */
+typedef struct {
+  /** Normalized text, index 1 also folded, NULL if not yet prepared. Set
+   * once with an atomic compare and swap, freed when the row is removed. */
+  RofiHaystackText *prepared[2];
+} RofiHaystackSlot;
+
+struct _RofiHaystackCache {
+  /** Number of fields per row. */
+  unsigned int num_fields;
+  /** Number of rows. */
+  unsigned int num_rows;
+  /** Number of rows allocated. */
+  unsigned int num_rows_allocated;
+  /** Slots, num_fields per row. */
+  RofiHaystackSlot *slots;
+};
+
+RofiHaystackCache *helper_haystack_cache_new(unsigned int num_fields) {
+  RofiHaystackCache *cache = g_malloc0(sizeof(RofiHaystackCache));
+  cache->num_fields = num_fields;
+  return cache;
+}
+
+void helper_haystack_cache_resize(RofiHaystackCache *cache,
+                                  unsigned int num_rows) {
+  if (cache == NULL) {
+    return;
+  }
+  for (size_t i = (size_t)num_rows * cache->num_fields;
+       i < (size_t)cache->num_rows * cache->num_fields; i++) {
+    for (unsigned int f = 0; f < 2; f++) {
+      g_free(cache->slots[i].prepared[f]);
+      cache->slots[i].prepared[f] = NULL;
+    }
+  }
+  if (num_rows > cache->num_rows_allocated) {
+    unsigned int old = cache->num_rows_allocated;
+    cache->num_rows_allocated = MAX(num_rows, 2 * old);
+    cache->slots =
+        g_realloc_n(cache->slots,
+                    (size_t)cache->num_rows_allocated * cache->num_fields,
+                    sizeof(RofiHaystackSlot));
+    memset(&(cache->slots[(size_t)old * cache->num_fields]), 0,
+           (size_t)(cache->num_rows_allocated - old) * cache->num_fields *
+               sizeof(RofiHaystackSlot));
+  }
+  cache->num_rows = num_rows;
+}
+
+void helper_haystack_cache_free(RofiHaystackCache *cache) {
+  if (cache == NULL) {
+    return;
+  }
+  helper_haystack_cache_resize(cache, 0);
+  g_free(cache->slots);
+  g_free(cache);
+}
+
+/**
+ * @param m The matcher.
+ *
+ * @returns TRUE if the matcher is case sensitive.
+ */
+static gboolean matcher_is_case_sensitive(const rofi_int_matcher *m) {
+  if (m->match != NULL) {
+    return m->case_sensitive;
+  }
+  return (g_regex_get_compile_flags(m->regex) & G_REGEX_CASELESS) == 0;
+}
+
+int helper_token_match_cached(rofi_int_matcher *const *tokens,
+                              RofiHaystackCache *cache, unsigned int row,
+                              unsigned int field, const char *input,
+                              gssize len) {
+  if (tokens == NULL || cache == NULL || !config.normalize_match ||
+      row >= cache->num_rows || field >= cache->num_fields) {
+    return helper_token_match_len(tokens, input, len);
+  }
+  // A row can be matched from several threads at once. The first to
+  // publish the prepared text wins, published text is never replaced.
+  RofiHaystackSlot *slot =
+      &(cache->slots[(size_t)row * cache->num_fields + field]);
+  gboolean fold = !config.case_sensitive;
+  RofiHaystackText **ptr = &(slot->prepared[fold ? 1 : 0]);
+  RofiHaystackText *prepared = g_atomic_pointer_get(ptr);
+  if (prepared == NULL) {
+    char *copy = (len < 0) ? NULL : g_strndup(input, len);
+    char *str = utf8_helper_simplify_string(copy ? copy : input);
+    g_free(copy);
+    if (fold) {
+      char *folded = helper_string_fold(str);
+      g_free(str);
+      str = folded;
+    }
+    size_t str_len = strlen(str);
+    prepared = g_malloc(sizeof(RofiHaystackText) + str_len + 1);
+    prepared->len = str_len;
+    memcpy(prepared->text, str, str_len + 1);
+    g_free(str);
+    if (!g_atomic_pointer_compare_and_exchange(ptr, NULL, prepared)) {
+      g_free(prepared);
+      prepared = g_atomic_pointer_get(ptr);
+    }
+  }
+  int match = TRUE;
+  for (int j = 0; match && tokens[j]; j++) {
+    if (fold && matcher_is_case_sensitive(tokens[j])) {
+      // Folded text cannot be used for a case sensitive token.
+      rofi_int_matcher *const ftokens[2] = {tokens[j], NULL};
+      match = helper_token_match_len(ftokens, input, len);
+      continue;
+    }
+    if (tokens[j]->match != NULL) {
+      match = tokens[j]->match(tokens[j], prepared->text, prepared->len,
+                               fold);
     } else {
-      for (int j = 0; match && tokens[j]; j++) {
-        match = g_regex_match(tokens[j]->regex, input, 0, NULL);
-        match ^= tokens[j]->invert;
+      match = g_regex_match(tokens[j]->regex, prepared->text, 0, NULL);
+    }
+    match ^= tokens[j]->invert;
+  }
+  return match;
+}
+
+struct _RofiColumnStore {
+  /** Number of columns. */
+  unsigned int num_columns;
+  /** Number of rows. */
+  unsigned int num_rows;
+  /** Number of rows allocated. */
+  unsigned int num_rows_allocated;
+  /** Per column, the string of each row. */
+  const char ***strings;
+  /** Per column, the length of each row. */
+  unsigned int **lengths;
+  /** The exported columns. */
+  ModeColumn *columns;
+};
+
+RofiColumnStore *helper_column_store_new(unsigned int num_columns) {
+  RofiColumnStore *store = g_malloc0(sizeof(RofiColumnStore));
+  store->num_columns = num_columns;
+  store->strings = g_malloc0_n(MAX(1, num_columns), sizeof(const char **));
+  store->lengths = g_malloc0_n(MAX(1, num_columns), sizeof(unsigned int *));
+  store->columns = g_malloc0_n(MAX(1, num_columns), sizeof(ModeColumn));
+  return store;
+}
+
+unsigned int helper_column_store_add_row(RofiColumnStore *store) {
+  if (store->num_rows == store->num_rows_allocated) {
+    store->num_rows_allocated = MAX(64, 2 * store->num_rows_allocated);
+    for (unsigned int c = 0; c < store->num_columns; c++) {
+      store->strings[c] = g_realloc_n(
+          store->strings[c], store->num_rows_allocated, sizeof(const char *));
+      store->lengths[c] = g_realloc_n(
+          store->lengths[c], store->num_rows_allocated, sizeof(unsigned int));
+    }
+  }
+  for (unsigned int c = 0; c < store->num_columns; c++) {
+    store->strings[c][store->num_rows] = NULL;
+    store->lengths[c][store->num_rows] = 0;
+  }
+  return store->num_rows++;
+}
+
+void helper_column_store_set(RofiColumnStore *store, unsigned int row,
+                             unsigned int column, const char *value,
+                             gssize len) {
+  g_return_if_fail(row < store->num_rows && column < store->num_columns);
+  if (value != NULL && len < 0) {
+    len = strlen(value);
+  }
+  store->strings[column][row] = value;
+  store->lengths[column][row] = (value != NULL) ? (unsigned int)len : 0;
+}
+
+unsigned int helper_column_store_get_num_rows(const RofiColumnStore *store) {
+  return store->num_rows;
+}
+
+const ModeColumn *helper_column_store_get_columns(RofiColumnStore *store) {
+  // The arrays move when they grow.
+  for (unsigned int c = 0; c < store->num_columns; c++) {
+    store->columns[c].strings = store->strings[c];
+    store->columns[c].lengths = store->lengths[c];
+  }
+  return store->columns;
+}
+
+void helper_column_store_free(RofiColumnStore *store) {
+  if (store == NULL) {
+    return;
+  }
+  for (unsigned int c = 0; c < store->num_columns; c++) {
+    g_free(store->strings[c]);
+    g_free(store->lengths[c]);
+  }
+  g_free(store->strings);
+  g_free(store->lengths);
+  g_free(store->columns);
+  g_free(store);
+}
+
+/** Size of the chunks of a #RofiStringArena. */
+#define STRING_ARENA_CHUNK_SIZE (64 * 1024)
+
+struct _RofiStringArena {
+  /** The chunks. */
+  GPtrArray *chunks;
+  /** Free space in the current chunk. */
+  char *free;
+  /** Number of bytes free in the current chunk. */
+  gsize left;
+  /** Number of bytes allocated. */
+  gsize size;
+};
+
+RofiStringArena *helper_string_arena_new(void) {
+  RofiStringArena *arena = g_malloc0(sizeof(RofiStringArena));
+  arena->chunks = g_ptr_array_new_with_free_func(g_free);
+  return arena;
+}
+
+char *helper_string_arena_add(RofiStringArena *arena, const char *str,
+                              gssize len) {
+  if (len < 0) {
+    len = strlen(str);
+  }
+  gsize need = (gsize)len + 1;
+  char *retv;
+  if (need > STRING_ARENA_CHUNK_SIZE / 4) {
+    // Large strings get a chunk of their own, keep filling the current one.
+    retv = g_malloc(need);
+    g_ptr_array_add(arena->chunks, retv);
+    arena->size += need;
+  } else {
+    if (need > arena->left) {
+      arena->free = g_malloc(STRING_ARENA_CHUNK_SIZE);
+      arena->left = STRING_ARENA_CHUNK_SIZE;
+      g_ptr_array_add(arena->chunks, arena->free);
+      arena->size += STRING_ARENA_CHUNK_SIZE;
+    }
+    retv = arena->free;
+    arena->free += need;
+    arena->left -= need;
+  }
+  memcpy(retv, str, len);
+  retv[len] = '\0';
+  return retv;
+}
+
+char *helper_string_arena_add_utf8(RofiStringArena *arena, const char *data,
+                                   gsize len) {
+  if (g_utf8_validate(data, len, NULL)) {
+    return helper_string_arena_add(arena, data, len);
+  }
+  char *utfstr = rofi_force_utf8(data, len);
+  char *retv = helper_string_arena_add(arena, utfstr, -1);
+  g_free(utfstr);
+  return retv;
+}
+
+void helper_string_arena_merge(RofiStringArena *arena,
+                               RofiStringArena *other) {
+  g_ptr_array_extend_and_steal(arena->chunks, other->chunks);
+  arena->size += other->size;
+  g_free(other);
+}
+
+gsize helper_string_arena_get_size(const RofiStringArena *arena) {
+  return arena->size;
+}
+
+void helper_string_arena_free(RofiStringArena *arena) {
+  if (arena == NULL) {
+    return;
+  }
+  g_ptr_array_free(arena->chunks, TRUE);
+  g_free(arena);
+}
+
+int helper_token_match_columns(rofi_int_matcher *const *tokens,
+                               const ModeColumns *columns, unsigned int row) {
+  int match = TRUE;
+  for (int j = 0; match && tokens && tokens[j]; j++) {
+    const rofi_int_matcher *t = tokens[j];
+    gboolean test = FALSE;
+    for (unsigned int c = 0; !test && c < columns->num_columns; c++) {
+      const ModeColumn *col = &(columns->columns[c]);
+      const char *input = col->strings[row];
+      if (input == NULL) {
+        continue;
+      }
+      if (t->match != NULL) {
+        test = t->match(t, input, col->lengths[row], FALSE);
+      } else {
+        test = g_regex_match_full(t->regex, input, col->lengths[row], 0, 0,
+                                  NULL, NULL);
       }
     }
+    match = test ^ t->invert;
   }
   return match;
 }
 
+/** Rows containing one trigram, in ascending order. */
+typedef struct {
+  /** The rows. */
+  unsigned int *rows;
+  /** Number of rows. */
+  unsigned int length;
+  /** Number of rows allocated. */
+  unsigned int allocated;
+} RofiTrigramPostings;
+
+/** Estimated cost of a posting list and its hash table entry, in bytes. */
+#define TRIGRAM_POSTINGS_OVERHEAD (sizeof(RofiTrigramPostings) + 32)
+
+struct _RofiTrigramIndex {
+  /** Lock, rows are added while the index is queried. */
+  GMutex mutex;
+  /** Maximum memory use in bytes. */
+  gsize budget;
+  /** Estimated memory use in bytes. */
+  gsize size;
+  /** Set when the budget was exceeded, the index is then dropped. */
+  gboolean overflow;
+  /** Number of rows indexed. */
+  unsigned int num_rows;
+  /** Map of trigram to RofiTrigramPostings. */
+  GHashTable *postings;
+  /** Rows with non-ASCII text, these can match ASCII case-insensitively. */
+  RofiTrigramPostings non_ascii;
+};
+
+static void trigram_postings_free(gpointer data) {
+  RofiTrigramPostings *p = (RofiTrigramPostings *)data;
+  g_free(p->rows);
+  g_free(p);
+}
+
+/**
+ * @param index The trigram index.
+ * @param p The posting list.
+ * @param row The row to add.
+ *
+ * Add row to the list, if it is not the last row in it already.
+ */
+static void trigram_postings_add(RofiTrigramIndex *index,
+                                 RofiTrigramPostings *p, unsigned int row) {
+  if (p->length > 0 && p->rows[p->length - 1] == row) {
+    return;
+  }
+  if (p->length == p->allocated) {
+    unsigned int allocated = MAX(4, 2 * p->allocated);
+    p->rows = g_realloc_n(p->rows, allocated, sizeof(unsigned int));
+    index->size += (allocated - p->allocated) * sizeof(unsigned int);
+    p->allocated = allocated;
+  }
+  p->rows[p->length++] = row;
+}
+
+/**
+ * @param p Pointer to 3 bytes.
+ *
+ * @returns the trigram at p, with ASCII lower-cased, as a non-zero key.
+ */
+static inline guint trigram_key(const char *p) {
+  return ((guint)matcher_ascii_tolower((guchar)p[0]) << 16) |
+         ((guint)matcher_ascii_tolower((guchar)p[1]) << 8) |
+         (guint)matcher_ascii_tolower((guchar)p[2]);
+}
+
+RofiTrigramIndex *helper_trigram_index_new(gsize budget) {
+  RofiTrigramIndex *index = g_malloc0(sizeof(RofiTrigramIndex));
+  g_mutex_init(&(index->mutex));
+  index->budget = budget;
+  index->postings = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                          trigram_postings_free);
+  return index;
+}
+
+void helper_trigram_index_add(RofiTrigramIndex *index, unsigned int row,
+                              const char *text, gssize len) {
+  g_mutex_lock(&(index->mutex));
+  index->num_rows = MAX(index->num_rows, row + 1);
+  if (index->overflow || text == NULL) {
+    g_mutex_unlock(&(index->mutex));
+    return;
+  }
+  if (len < 0) {
+    len = strlen(text);
+  }
+  for (gssize i = 0; i < len; i++) {
+    if ((guchar)text[i] >= 0x80) {
+      trigram_postings_add(index, &(index->non_ascii), row);
+      break;
+    }
+  }
+  for (gssize i = 0; i + 2 < len; i++) {
+    gpointer key = GUINT_TO_POINTER(trigram_key(text + i));
+    RofiTrigramPostings *p = g_hash_table_lookup(index->postings, key);
+    if (p == NULL) {
+      p = g_malloc0(sizeof(RofiTrigramPostings));
+      g_hash_table_insert(index->postings, key, p);
+      index->size += TRIGRAM_POSTINGS_OVERHEAD;
+    }
+    trigram_postings_add(index, p, row);
+  }
+  if (index->size > index->budget) {
+    g_debug("Trigram index exceeds %" G_GSIZE_FORMAT " bytes, dropping it.",
+            index->budget);
+    index->overflow = TRUE;
+    g_hash_table_remove_all(index->postings);
+    g_free(index->non_ascii.rows);
+    memset(&(index->non_ascii), 0, sizeof(RofiTrigramPostings));
+    index->size = 0;
+  }
+  g_mutex_unlock(&(index->mutex));
+}
+
+void helper_trigram_index_free(RofiTrigramIndex *index) {
+  if (index == NULL) {
+    return;
+  }
+  g_hash_table_destroy(index->postings);
+  g_free(index->non_ascii.rows);
+  g_mutex_clear(&(index->mutex));
+  g_free(index);
+}
+
+/**
+ * @param a Sorted rows, the result is stored here.
+ * @param alen Number of rows in a.
+ * @param b Sorted rows.
+ * @param blen Number of rows in b.
+ *
+ * Intersect a with b in place.
+ *
+ * @returns the number of rows left in a.
+ */
+static unsigned int trigram_rows_intersect(unsigned int *a, unsigned int alen,
+                                           const unsigned int *b,
+                                           unsigned int blen) {
+  unsigned int i = 0, j = 0, n = 0;
+  while (i < alen && j < blen) {
+    if (a[i] < b[j]) {
+      i++;
+    } else if (a[i] > b[j]) {
+      j++;
+    } else {
+      a[n++] = a[i];
+      i++;
+      j++;
+    }
+  }
+  return n;
+}
+
+/**
+ * @param a Sorted rows, freed.
+ * @param alen Number of rows in a.
+ * @param b Sorted rows.
+ * @param blen Number of rows in b.
+ * @param length Set to the number of rows in the result.
+ *
+ * @returns the union of a and b, free with g_free.
+ */
+static unsigned int *trigram_rows_union(unsigned int *a, unsigned int alen,
+                                        const unsigned int *b,
+                                        unsigned int blen,
+                                        unsigned int *length) {
+  unsigned int *retv = g_malloc_n(MAX(1, alen + blen), sizeof(unsigned int));
+  unsigned int i = 0, j = 0, n = 0;
+  while (i < alen || j < blen) {
+    if (j == blen || (i < alen && a[i] < b[j])) {
+      retv[n++] = a[i++];
+    } else if (i == alen || b[j] < a[i]) {
+      retv[n++] = b[j++];
+    } else {
+      retv[n++] = a[i];
+      i++;
+      j++;
+    }
+  }
+  g_free(a);
+  *length = n;
+  return retv;
+}
+
+static gint trigram_postings_cmp_length(gconstpointer a, gconstpointer b) {
+  const RofiTrigramPostings *pa = *(RofiTrigramPostings *const *)a;
+  const RofiTrigramPostings *pb = *(RofiTrigramPostings *const *)b;
+  return (pa->length > pb->length) - (pa->length < pb->length);
+}
+
+/**
+ * @param index The trigram index.
+ * @param t The token.
+ * @param length Set to the number of candidate rows.
+ *
+ * Find the rows that can match token t. Called with the index locked.
+ *
+ * @returns the sorted candidate rows, or NULL if t cannot be looked up.
+ */
+static unsigned int *trigram_index_query_token(RofiTrigramIndex *index,
+                                               const rofi_int_matcher *t,
+                                               unsigned int *length) {
+  if (t->invert || t->needle == NULL ||
+      (t->match != matcher_match_normal && t->match != matcher_match_prefix &&
+       t->match != matcher_match_glob)) {
+    return NULL;
+  }
+  // Non-ASCII lower-cased characters are not indexed in folded form.
+  if (!t->case_sensitive && !t->ascii) {
+    return NULL;
+  }
+  GPtrArray *lists = g_ptr_array_new();
+  gboolean missing = FALSE;
+  const char *run = t->needle;
+  const char *end = t->needle + t->needle_len;
+  while (run < end && !missing) {
+    // Split glob patterns in the literal runs between wildcards.
+    const char *run_end = run;
+    while (run_end < end && (t->match != matcher_match_glob ||
+                             (*run_end != '*' && *run_end != '?'))) {
+      run_end++;
+    }
+    for (const char *p = run; p + 2 < run_end; p++) {
+      RofiTrigramPostings *pl = g_hash_table_lookup(
+          index->postings, GUINT_TO_POINTER(trigram_key(p)));
+      if (pl == NULL) {
+        missing = TRUE;
+        break;
+      }
+      g_ptr_array_add(lists, pl);
+    }
+    run = run_end + 1;
+  }
+  if (!missing && lists->len == 0) {
+    g_ptr_array_free(lists, TRUE);
+    return NULL;
+  }
+  unsigned int *rows = NULL;
+  unsigned int n = 0;
+  if (!missing) {
+    // Start with the shortest list, it bounds the result.
+    g_ptr_array_sort(lists, trigram_postings_cmp_length);
+    RofiTrigramPostings *first = g_ptr_array_index(lists, 0);
+    rows = g_memdup2(first->rows,
+                     MAX(1, first->length) * sizeof(unsigned int));
+    n = first->length;
+    for (guint i = 1; i < lists->len && n > 0; i++) {
+      RofiTrigramPostings *pl = g_ptr_array_index(lists, i);
+      n = trigram_rows_intersect(rows, n, pl->rows, pl->length);
+    }
+  }
+  g_ptr_array_free(lists, TRUE);
+  if (!t->case_sensitive) {
+    rows = trigram_rows_union(rows, n, index->non_ascii.rows,
+                              index->non_ascii.length, &n);
+  } else if (rows == NULL) {
+    rows = g_malloc(sizeof(unsigned int));
+  }
+  *length = n;
+  return rows;
+}
+
+unsigned int *helper_trigram_index_query(RofiTrigramIndex *index,
+                                         rofi_int_matcher *const *tokens,
+                                         unsigned int num_rows,
+                                         unsigned int *length) {
+  unsigned int *retv = NULL;
+  unsigned int n = 0;
+  g_mutex_lock(&(index->mutex));
+  if (index->overflow || index->num_rows < num_rows) {
+    g_mutex_unlock(&(index->mutex));
+    return NULL;
+  }
+  for (int j = 0; tokens && tokens[j]; j++) {
+    unsigned int tn = 0;
+    unsigned int *rows = trigram_index_query_token(index, tokens[j], &tn);
+    if (rows == NULL) {
+      continue;
+    }
+    if (retv == NULL) {
+      retv = rows;
+      n = tn;
+    } else {
+      n = trigram_rows_intersect(retv, n, rows, tn);
+      g_free(rows);
+    }
+    if (n == 0) {
+      break;
+    }
+  }
+  g_mutex_unlock(&(index->mutex));
+  // Rows added after num_rows are not part of the query.
+  while (retv != NULL && n > 0 && retv[n - 1] >= num_rows) {
+    n--;
+  }
+  *length = n;
+  return retv;
+}
+
 int execute_generator(const char *cmd) {
   char **args = NULL;
   int argv = 0;
@@ -762,9 +1738,181 @@ char *rofi_expand_path(const char *input) {
   return retv;
 }
 
-/** Return the minimum value of a,b,c */
-#define MIN3(a, b, c)                                                          \
-  ((a) < (b) ? ((a) < (c) ? (a) : (c)) : ((b) < (c) ? (b) : (c)))
+/** Number of needle characters handled by one bit-vector word. */
+#define LEV_WORD_BITS 64
+/** Number of words kept on the stack, longer needles allocate. */
+#define LEV_STACK_WORDS 4
+
+struct _RofiLevenshteinNeedle {
+  /** Length of the needle in characters. */
+  glong length;
+  /** Number of 64 bit words per bit-vector. */
+  unsigned int words;
+  /** If the needle and haystack are compared case sensitive. */
+  gboolean case_sensitive;
+  /** Match vectors for ASCII characters, 128 * words. */
+  guint64 *ascii;
+  /** Distinct non-ASCII characters in the needle. */
+  gunichar *chars;
+  /** Match vectors for chars, num_chars * words. */
+  guint64 *peq;
+  /** Number of entries in chars. */
+  unsigned int num_chars;
+  /** All zero vector for characters not in the needle. */
+  guint64 *zero;
+};
+
+RofiLevenshteinNeedle *levenshtein_needle_new(const char *needle,
+                                              const glong needlelen) {
+  RofiLevenshteinNeedle *n = g_malloc0(sizeof(RofiLevenshteinNeedle));
+  n->length = needlelen;
+  n->case_sensitive = config.case_sensitive;
+  n->words = MAX(1, (needlelen + LEV_WORD_BITS - 1) / LEV_WORD_BITS);
+  n->ascii = g_malloc0_n(128 * n->words, sizeof(guint64));
+  n->zero = g_malloc0_n(n->words, sizeof(guint64));
+  const char *iter = needle;
+  for (glong i = 0; i < needlelen; i++, iter = g_utf8_next_char(iter)) {
+    gunichar c = g_utf8_get_char(iter);
+    if (!n->case_sensitive) {
+      c = g_unichar_tolower(c);
+    }
+    guint64 bit = G_GUINT64_CONSTANT(1) << (i % LEV_WORD_BITS);
+    unsigned int word = i / LEV_WORD_BITS;
+    if (c < 128) {
+      n->ascii[c * n->words + word] |= bit;
+      continue;
+    }
+    unsigned int k = 0;
+    while (k < n->num_chars && n->chars[k] != c) {
+      k++;
+    }
+    if (k == n->num_chars) {
+      n->num_chars++;
+      n->chars = g_realloc_n(n->chars, n->num_chars, sizeof(gunichar));
+      n->peq = g_realloc_n(n->peq, n->num_chars * n->words, sizeof(guint64));
+      n->chars[k] = c;
+      memset(&(n->peq[k * n->words]), 0, n->words * sizeof(guint64));
+    }
+    n->peq[k * n->words + word] |= bit;
+  }
+  return n;
+}
+
+void levenshtein_needle_free(RofiLevenshteinNeedle *n) {
+  if (n == NULL) {
+    return;
+  }
+  g_free(n->ascii);
+  g_free(n->chars);
+  g_free(n->peq);
+  g_free(n->zero);
+  g_free(n);
+}
+
+/**
+ * @param n The needle.
+ * @param c The (folded) haystack character.
+ *
+ * @returns the match bit-vector of c.
+ */
+static inline const guint64 *lev_peq(const RofiLevenshteinNeedle *n,
+                                     gunichar c) {
+  if (c < 128) {
+    return &(n->ascii[c * n->words]);
+  }
+  for (unsigned int k = 0; k < n->num_chars; k++) {
+    if (n->chars[k] == c) {
+      return &(n->peq[k * n->words]);
+    }
+  }
+  return n->zero;
+}
+
+/**
+ * @param pv The positive vertical delta vector of the word.
+ * @param mv The negative vertical delta vector of the word.
+ * @param eq The match vector of the word.
+ * @param hin The horizontal delta entering the word at the top (-1, 0, 1).
+ * @param high The bit of the last needle character in the word.
+ *
+ * Advance one word of the bit-parallel (Myers/Hyyro) column by one haystack
+ * character.
+ *
+ * @returns the horizontal delta leaving the word at the bottom.
+ */
+static inline int lev_advance_word(guint64 *pv, guint64 *mv, guint64 eq,
+                                   int hin, guint64 high) {
+  guint64 hin_neg = (hin < 0) ? 1 : 0;
+  guint64 xv = eq | *mv;
+  eq |= hin_neg;
+  guint64 xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+  guint64 ph = *mv | ~(xh | *pv);
+  guint64 mh = *pv & xh;
+  int hout = 0;
+  if (ph & high) {
+    hout = 1;
+  } else if (mh & high) {
+    hout = -1;
+  }
+  ph = (ph << 1) | ((hin > 0) ? 1 : 0);
+  mh = (mh << 1) | hin_neg;
+  *pv = mh | ~(xv | ph);
+  *mv = ph & xv;
+  return hout;
+}
+
+unsigned int levenshtein_needle_distance(const RofiLevenshteinNeedle *n,
+                                         const char *haystack,
+                                         const glong haystacklen,
+                                         unsigned int bound) {
+  guint64 stack[2 * LEV_STACK_WORDS];
+  guint64 *pv = (n->words <= LEV_STACK_WORDS)
+                    ? stack
+                    : g_malloc_n(2 * n->words, sizeof(guint64));
+  guint64 *mv = pv + n->words;
+  for (unsigned int w = 0; w < n->words; w++) {
+    pv[w] = ~G_GUINT64_CONSTANT(0);
+    mv[w] = 0;
+  }
+  guint64 last_high = G_GUINT64_CONSTANT(1)
+                      << ((MAX(1, n->length) - 1) % LEV_WORD_BITS);
+  // Distance between the needle and the empty prefix of the haystack.
+  glong score = n->length;
+  glong x = 0;
+  for (const char *iter = haystack;
+       (haystacklen < 0) ? (*iter != '\0') : (x < haystacklen);
+       iter = g_utf8_next_char(iter), x++) {
+    gunichar c = g_utf8_get_char(iter);
+    if (!n->case_sensitive) {
+      c = g_unichar_tolower(c);
+    }
+    if (n->length == 0) {
+      score++;
+      continue;
+    }
+    const guint64 *eq = lev_peq(n, c);
+    // The top row of the matrix grows by one per character.
+    int h = 1;
+    for (unsigned int w = 0; w < n->words; w++) {
+      guint64 high = (w + 1 == n->words) ? last_high
+                                         : G_GUINT64_CONSTANT(1) << 63;
+      h = lev_advance_word(&pv[w], &mv[w], eq[w], h, high);
+    }
+    score += h;
+    // The last row changes by at most one per remaining character.
+    if (haystacklen >= 0 &&
+        (gint64)score - (haystacklen - x - 1) > (gint64)bound) {
+      break;
+    }
+  }
+  if (pv != stack) {
+    g_free(pv);
+  }
+  if ((gint64)score > (gint64)bound) {
+    return bound + 1;
+  }
+  return (unsigned int)score;
+}
 
 unsigned int levenshtein(const char *needle, const glong needlelen,
                          const char *haystack, const glong haystacklen) {
@@ -772,34 +1920,11 @@ unsigned int levenshtein(const char *needle, const glong needlelen,
     // String to long, we cannot handle this.
     return UINT_MAX;
   }
-  unsigned int column[needlelen + 1];
-  for (glong y = 0; y < needlelen; y++) {
-    column[y] = y;
-  }
-  // Removed out of the loop, otherwise static code analyzers think it is
-  // unset.. silly but true. old loop: for ( glong y = 0; y <= needlelen; y++)
-  column[needlelen] = needlelen;
-  for (glong x = 1; x <= haystacklen; x++) {
-    const char *needles = needle;
-    column[0] = x;
-    gunichar haystackc = g_utf8_get_char(haystack);
-    if (!config.case_sensitive) {
-      haystackc = g_unichar_tolower(haystackc);
-    }
-    for (glong y = 1, lastdiag = x - 1; y <= needlelen; y++) {
-      gunichar needlec = g_utf8_get_char(needles);
-      if (!config.case_sensitive) {
-        needlec = g_unichar_tolower(needlec);
-      }
-      unsigned int olddiag = column[y];
-      column[y] = MIN3(column[y] + 1, column[y - 1] + 1,
-                       lastdiag + (needlec == haystackc ? 0 : 1));
-      lastdiag = olddiag;
-      needles = g_utf8_next_char(needles);
-    }
-    haystack = g_utf8_next_char(haystack);
-  }
-  return column[needlelen];
+  RofiLevenshteinNeedle *n = levenshtein_needle_new(needle, needlelen);
+  unsigned int retv =
+      levenshtein_needle_distance(n, haystack, haystacklen, UINT_MAX);
+  levenshtein_needle_free(n);
+  return retv;
 }
 
 char *rofi_latin_to_utf8_strdup(const char *input, gssize length) {
@@ -840,8 +1965,6 @@ char *rofi_force_utf8(const gchar *data, ssize_t length) {
  * FZF like scorer
  */
 
-/** Max length of input to score. */
-#define FUZZY_SCORER_MAX_LENGTH 256
 /** minimum score */
 #define MIN_SCORE (INT_MIN / 2)
 /** Leading gap score */
@@ -875,12 +1998,46 @@ enum CharClass {
   NON_WORD
 };
 
+/**
+ * Character class of each ASCII character, so the common case does not need
+ * the unicode tables.
+ */
+static const guint8 rofi_scorer_ascii_class[128] = {
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD,
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD,
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD,
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD,
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD,
+    /* ' ' - '/' */
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD,
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD,
+    NON_WORD, NON_WORD,
+    /* '0' - '9' */
+    DIGIT, DIGIT, DIGIT, DIGIT, DIGIT, DIGIT, DIGIT, DIGIT, DIGIT, DIGIT,
+    /* ':' - '@' */
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD,
+    /* 'A' - 'Z' */
+    UPPER, UPPER, UPPER, UPPER, UPPER, UPPER, UPPER, UPPER, UPPER, UPPER,
+    UPPER, UPPER, UPPER, UPPER, UPPER, UPPER, UPPER, UPPER, UPPER, UPPER,
+    UPPER, UPPER, UPPER, UPPER, UPPER, UPPER,
+    /* '[' - '`' */
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD,
+    /* 'a' - 'z' */
+    LOWER, LOWER, LOWER, LOWER, LOWER, LOWER, LOWER, LOWER, LOWER, LOWER,
+    LOWER, LOWER, LOWER, LOWER, LOWER, LOWER, LOWER, LOWER, LOWER, LOWER,
+    LOWER, LOWER, LOWER, LOWER, LOWER, LOWER,
+    /* '{' - DEL */
+    NON_WORD, NON_WORD, NON_WORD, NON_WORD, NON_WORD};
+
 /**
  * @param c The character to determine class of
  *
  * @returns the class of the character c.
  */
 static enum CharClass rofi_scorer_get_character_class(gunichar c) {
+  if (c < 0x80) {
+    return rofi_scorer_ascii_class[c];
+  }
   if (g_unichar_islower(c)) {
     return LOWER;
   }
@@ -914,63 +2071,203 @@ static int rofi_scorer_get_score_for(enum CharClass prev, enum CharClass curr) {
   return 0;
 }
 
+/**
+ * Per thread working memory of the scorer, grown on demand and kept between
+ * calls so scoring a row does not allocate.
+ */
+typedef struct {
+  /** Allocated number of haystack characters. */
+  glong str_size;
+  /** The (case folded) haystack characters. */
+  gunichar *str;
+  /** Score of matching each haystack character. */
+  int *score;
+  /** The dynamic programming row. */
+  int *dp;
+  /** Allocated number of pattern characters. */
+  glong pat_size;
+  /** The (case folded) pattern characters, without white space. */
+  gunichar *pat;
+  /** If each pattern character starts a word. */
+  gboolean *pstart;
+  /** First haystack position each pattern character can align to. */
+  glong *lo;
+  /** Last haystack position each pattern character can align to. */
+  glong *hi;
+} RofiScorerScratch;
+
+/**
+ * @param data The RofiScorerScratch to free.
+ *
+ * Free the scorer memory of a thread on exit.
+ */
+static void rofi_scorer_scratch_free(gpointer data) {
+  RofiScorerScratch *s = (RofiScorerScratch *)data;
+  g_free(s->str);
+  g_free(s->score);
+  g_free(s->dp);
+  g_free(s->pat);
+  g_free(s->pstart);
+  g_free(s->lo);
+  g_free(s->hi);
+  g_free(s);
+}
+
+/** The scorer memory of the calling thread. */
+static GPrivate rofi_scorer_scratch_key =
+    G_PRIVATE_INIT(rofi_scorer_scratch_free);
+
+/**
+ * @param plen The number of pattern characters.
+ * @param slen The number of haystack characters.
+ *
+ * @returns the scorer memory of this thread, large enough for plen and slen.
+ */
+static RofiScorerScratch *rofi_scorer_scratch_get(glong plen, glong slen) {
+  RofiScorerScratch *s = g_private_get(&rofi_scorer_scratch_key);
+  if (s == NULL) {
+    s = g_malloc0(sizeof(RofiScorerScratch));
+    g_private_set(&rofi_scorer_scratch_key, s);
+  }
+  if (slen > s->str_size) {
+    s->str_size = MAX(slen, 2 * s->str_size);
+    s->str = g_realloc_n(s->str, s->str_size, sizeof(gunichar));
+    s->score = g_realloc_n(s->score, s->str_size, sizeof(int));
+    s->dp = g_realloc_n(s->dp, s->str_size, sizeof(int));
+  }
+  if (plen > s->pat_size) {
+    s->pat_size = MAX(plen, 2 * s->pat_size);
+    s->pat = g_realloc_n(s->pat, s->pat_size, sizeof(gunichar));
+    s->pstart = g_realloc_n(s->pstart, s->pat_size, sizeof(gboolean));
+    s->lo = g_realloc_n(s->lo, s->pat_size, sizeof(glong));
+    s->hi = g_realloc_n(s->hi, s->pat_size, sizeof(glong));
+  }
+  return s;
+}
+
+/**
+ * @param s The scorer memory holding the pattern and haystack.
+ * @param plen The number of pattern characters in s.
+ * @param slen The number of haystack characters in s.
+ *
+ * Limit each pattern character to the haystack positions it can take in a
+ * complete alignment: between its leftmost greedy match and its rightmost
+ * greedy match. Cells outside this band can never be part of the result.
+ *
+ * @returns TRUE if the pattern is a subsequence of the haystack.
+ */
+static gboolean rofi_scorer_band(RofiScorerScratch *s, glong plen,
+                                 glong slen) {
+  glong si = 0;
+  for (glong pi = 0; pi < plen; pi++, si++) {
+    while (si < slen && s->str[si] != s->pat[pi]) {
+      si++;
+    }
+    if (si == slen) {
+      return FALSE;
+    }
+    s->lo[pi] = si;
+  }
+  si = slen - 1;
+  for (glong pi = plen - 1; pi >= 0; pi--, si--) {
+    while (s->str[si] != s->pat[pi]) {
+      si--;
+    }
+    s->hi[pi] = si;
+  }
+  return TRUE;
+}
+
 int rofi_scorer_fuzzy_evaluate(const char *pattern, glong plen, const char *str,
                                glong slen) {
-  if (slen > FUZZY_SCORER_MAX_LENGTH) {
-    return -MIN_SCORE;
-  }
-  glong pi, si;
-  // whether we are aligning the first character of pattern
-  gboolean pfirst = TRUE;
+  RofiScorerScratch *s = rofi_scorer_scratch_get(plen, slen);
+  gboolean fold = !config.case_sensitive;
+  glong pi, si, np = 0;
   // whether the start of a word in pattern
   gboolean pstart = TRUE;
-  // score for each position
-  int *score = g_malloc_n(slen, sizeof(int));
-  // dp[i]: maximum value by aligning pattern[0..pi] to str[0..si]
-  int *dp = g_malloc_n(slen, sizeof(int));
-  // uleft: value of the upper left cell; ulefts: maximum value of uleft and
-  // cells on the left. The arbitrary initial values suppress warnings.
-  int uleft = 0, ulefts = 0, left, lefts;
-  const gchar *pit = pattern, *sit;
+  const gchar *it;
   enum CharClass prev = NON_WORD;
-  for (si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char(sit)) {
-    enum CharClass cur = rofi_scorer_get_character_class(g_utf8_get_char(sit));
-    score[si] = rofi_scorer_get_score_for(prev, cur);
+  for (si = 0, it = str; si < slen; si++) {
+    gunichar c = (guchar)*it;
+    enum CharClass cur;
+    if (c < 0x80) {
+      cur = rofi_scorer_ascii_class[c];
+      s->str[si] = fold ? (gunichar)g_ascii_tolower(c) : c;
+      it++;
+    } else {
+      c = g_utf8_get_char(it);
+      cur = rofi_scorer_get_character_class(c);
+      s->str[si] = fold ? g_unichar_tolower(c) : c;
+      it = g_utf8_next_char(it);
+    }
+    s->score[si] = rofi_scorer_get_score_for(prev, cur);
     prev = cur;
-    dp[si] = MIN_SCORE;
   }
-  for (pi = 0; pi < plen; pi++, pit = g_utf8_next_char(pit)) {
-    gunichar pc = g_utf8_get_char(pit), sc;
+  for (pi = 0, it = pattern; pi < plen; pi++, it = g_utf8_next_char(it)) {
+    gunichar pc = g_utf8_get_char(it);
     if (g_unichar_isspace(pc)) {
       pstart = TRUE;
       continue;
     }
-    lefts = MIN_SCORE;
-    for (si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char(sit)) {
-      left = dp[si];
+    s->pat[np] = fold ? g_unichar_tolower(pc) : pc;
+    s->pstart[np] = pstart;
+    pstart = FALSE;
+    np++;
+  }
+  if (np == 0 || slen == 0) {
+    return -MIN_SCORE;
+  }
+  if (!rofi_scorer_band(s, np, slen)) {
+    // Not a full match, the score is only a tie breaker. Fill the whole table
+    // to rank it like before.
+    for (pi = 0; pi < np; pi++) {
+      s->lo[pi] = 0;
+      s->hi[pi] = slen - 1;
+    }
+  }
+
+  int *dp = s->dp;
+  // uleft: value of the upper left cell; ulefts: maximum value of uleft and
+  // cells on the left.
+  int uleft, ulefts, left, lefts = MIN_SCORE;
+  for (si = s->lo[0]; si <= s->hi[0]; si++) {
+    int t = s->score[si] * (s->pstart[0] ? PATTERN_START_MULTIPLIER
+                                          : PATTERN_NON_START_MULTIPLIER);
+    dp[si] = s->str[si] == s->pat[0] ? LEADING_GAP_SCORE * si + t : MIN_SCORE;
+  }
+  for (pi = 1; pi < np; pi++) {
+    glong plo = s->lo[pi - 1], phi = s->hi[pi - 1];
+    gunichar pc = s->pat[pi];
+    int mult = s->pstart[pi] ? PATTERN_START_MULTIPLIER
+                             : PATTERN_NON_START_MULTIPLIER;
+    uleft = ulefts = lefts = MIN_SCORE;
+    // Cells of the previous row left of the band only feed the gap maximum.
+    for (si = plo; si < s->lo[pi]; si++) {
+      uleft = si <= phi ? dp[si] : MIN_SCORE;
+      ulefts = lefts = MAX(lefts + GAP_SCORE, uleft);
+    }
+    for (si = s->lo[pi]; si <= s->hi[pi]; si++) {
+      left = si <= phi ? dp[si] : MIN_SCORE;
       lefts = MAX(lefts + GAP_SCORE, left);
-      sc = g_utf8_get_char(sit);
-      if (config.case_sensitive
-              ? pc == sc
-              : g_unichar_tolower(pc) == g_unichar_tolower(sc)) {
-        int t = score[si] * (pstart ? PATTERN_START_MULTIPLIER
-                                    : PATTERN_NON_START_MULTIPLIER);
-        dp[si] = pfirst ? LEADING_GAP_SCORE * si + t
-                        : MAX(uleft + CONSECUTIVE_SCORE, ulefts + t);
+      if (s->str[si] == pc) {
+        dp[si] = MAX(uleft + CONSECUTIVE_SCORE, ulefts + s->score[si] * mult);
       } else {
         dp[si] = MIN_SCORE;
       }
       uleft = left;
       ulefts = lefts;
     }
-    pfirst = pstart = FALSE;
   }
+  glong last = s->hi[np - 1];
   lefts = MIN_SCORE;
-  for (si = 0; si < slen; si++) {
+  for (si = s->lo[np - 1]; si <= last; si++) {
     lefts = MAX(lefts + GAP_SCORE, dp[si]);
   }
-  g_free(score);
-  g_free(dp);
+  // The gap after the last aligned character.
+  if (lefts > MIN_SCORE) {
+    lefts += GAP_SCORE * (int)(slen - 1 - last);
+    lefts = MAX(lefts, MIN_SCORE);
+  }
   return -lefts;
 }
 
@@ -1233,6 +2530,14 @@ void parse_ranges(char *input, rofi_range_pair **list, unsigned int *length) {
 }
 void rofi_output_formatted_line(const char *format, const char *string,
                                 int selected_line, const char *filter) {
+  rofi_output_formatted_line_buffered(format, string, selected_line, filter);
+  fflush(stdout);
+}
+
+void rofi_output_formatted_line_buffered(const char *format,
+                                         const char *string,
+                                         int selected_line,
+                                         const char *filter) {
   for (int i = 0; format && format[i]; i++) {
     if (format[i] == 'i') {
       fprintf(stdout, "%d", selected_line);
@@ -1268,7 +2573,6 @@ void rofi_output_formatted_line(const char *format, const char *string,
     }
   }
   fputc('\n', stdout);
-  fflush(stdout);
 }
 
 static gboolean helper_eval_cb2(const GMatchInfo *info, GString *res,
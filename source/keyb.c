@@ -434,6 +434,16 @@ guint key_binding_get_action_from_name(const char *name) {
   return UINT32_MAX;
 }
 
+BindingsScope key_binding_get_scope_from_name(const char *name) {
+  for (gsize i = 0; i < G_N_ELEMENTS(rofi_bindings); ++i) {
+    ActionBindingEntry *b = &rofi_bindings[i];
+    if (g_strcmp0(b->name, name) == 0) {
+      return b->scope;
+    }
+  }
+  return SCOPE_GLOBAL;
+}
+
 gboolean parse_keys_abe(NkBindings *bindings) {
   GError *error = NULL;
   GString *error_msg = g_string_new("");
@@ -128,6 +128,19 @@ char *mode_get_completion(const Mode *mode, unsigned int selected_line) {
   return mode->_get_display_value(mode, selected_line, &state, NULL, TRUE);
 }
 
+const char *mode_peek_completion(const Mode *mode,
+                                 unsigned int selected_line) {
+  g_assert(mode != NULL);
+  // Plugins built against an older ABI do not have the field.
+  if (mode->module != NULL && mode->abi_version < 8u) {
+    return NULL;
+  }
+  if (mode->_peek_completion == NULL) {
+    return NULL;
+  }
+  return mode->_peek_completion(mode, selected_line);
+}
+
 ModeMode mode_result(Mode *mode, int menu_retv, char **input,
                      unsigned int selected_line) {
   if (menu_retv & MENU_NEXT) {
@@ -154,6 +167,19 @@ int mode_token_match(const Mode *mode, rofi_int_matcher **tokens,
   return mode->_token_match(mode, tokens, selected_line);
 }
 
+gboolean mode_get_columns(const Mode *mode, ModeColumns *columns) {
+  g_assert(mode != NULL);
+  g_assert(columns != NULL);
+  // Plugins built against an older ABI do not have the field.
+  if (mode->module != NULL && mode->abi_version < 8u) {
+    return FALSE;
+  }
+  if (mode->_get_columns == NULL) {
+    return FALSE;
+  }
+  return mode->_get_columns(mode, columns);
+}
+
 const char *mode_get_name(const Mode *mode) {
   g_assert(mode != NULL);
   return mode->name;
@@ -285,6 +285,18 @@ static char *combi_get_completion(const Mode *sw, unsigned int index) {
   return NULL;
 }
 
+static const char *combi_peek_completion(const Mode *sw, unsigned int index) {
+  CombiModePrivateData *pd = mode_get_private_data(sw);
+  for (unsigned i = 0; i < pd->num_switchers; i++) {
+    if (index >= pd->starts[i] && index < (pd->starts[i] + pd->lengths[i])) {
+      // Scored without the '!mode ' prefix of the completion.
+      return mode_peek_completion(pd->switchers[i].mode,
+                                  index - pd->starts[i]);
+    }
+  }
+  return NULL;
+}
+
 static cairo_surface_t *combi_get_icon(const Mode *sw, unsigned int index,
                                        unsigned int height) {
   CombiModePrivateData *pd = mode_get_private_data(sw);
@@ -338,6 +350,7 @@ Mode combi_mode = {.name = "combi",
                    ._destroy = combi_mode_destroy,
                    ._token_match = combi_mode_match,
                    ._get_completion = combi_get_completion,
+                   ._peek_completion = combi_peek_completion,
                    ._get_display_value = combi_mgrv,
                    ._get_icon = combi_get_icon,
                    ._preprocess_input = combi_preprocess_input,
@@ -48,6 +48,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -74,6 +75,34 @@ static inline void bittoggle(uint32_t *const array, unsigned int index) {
   *v ^= 1 << bit;
 }
 
+/**
+ * A row of input. The strings are kept in the string arena, or in the mapped
+ * -input file, and the optional fields in a side table, as most rows have
+ * none.
+ */
+typedef struct {
+  /** Entry content, in the string arena or the mapped -input file. Only
+   * the entries in the arena are NUL terminated. */
+  const char *entry;
+  /** Length of entry in bytes. */
+  uint32_t length;
+  /** Index of the optional fields in the side table plus one, 0 if none. */
+  uint32_t extras;
+  /** With -markup-rows, index of the entry stripped from markup in the side
+   * table plus one, 0 if that equals the entry, UINT32_MAX if the markup is
+   * invalid. */
+  uint32_t stripped;
+} DmenuRow;
+
+/** A selected column of a row with -display-columns. */
+typedef struct {
+  /** Offset of the column in the display text of the row. */
+  uint32_t start;
+  /** Length of the column in bytes, UINT32_MAX if the row does not have it.
+   */
+  uint32_t len;
+} DmenuColumnSpan;
+
 typedef struct {
   /** Settings */
   // Separator.
@@ -90,14 +119,30 @@ typedef struct {
   unsigned int num_selected_list;
   unsigned int do_markup;
   // List with entries.
-  DmenuScriptEntry *cmd_list;
+  DmenuRow *cmd_list;
   unsigned int cmd_list_real_length;
   unsigned int cmd_list_length;
+  /** The optional fields of the rows that have them, see DmenuRow. */
+  GArray *extras;
+  /** The entries stripped from markup that differ, see DmenuRow. */
+  GPtrArray *stripped;
+  /** Holds all strings of the rows that are not in map. */
+  RofiStringArena *arena;
+  /** The -input file mapped in memory (or NULL), rows point into it. */
+  char *map;
+  /** Length of map in bytes. */
+  gsize map_len;
   unsigned int only_selected;
   unsigned int selected_count;
 
   gchar **columns;
   gchar *column_separator;
+  /** Number of selected columns in columns. */
+  unsigned int num_columns;
+  /** The compiled column_separator, NULL if it is invalid. */
+  GRegex *column_regex;
+  /** Spans of the selected columns, num_columns per row. */
+  GArray *column_spans;
   gboolean multi_select;
 
   GThread *reading_thread;
@@ -112,17 +157,290 @@ typedef struct {
 
   char *ballot_selected;
   char *ballot_unselected;
+
+  /** Normalized entry and meta text, when normalize-match is enabled. */
+  RofiHaystackCache *haystack;
+  /** Entry, meta and completion text, see dmenu_get_columns. */
+  RofiColumnStore *column_store;
+  /** If a row can not be matched from the column store. */
+  gboolean no_columns;
+  /** Trigram index of entry and meta, see -trigram-index. */
+  RofiTrigramIndex *trigram_index;
+  /** Number of rows added to the trigram index. */
+  unsigned int trigram_rows;
 } DmenuModePrivateData;
 
+/** Matchable fields of a row in the haystack cache. */
+enum { DMENU_FIELD_ENTRY, DMENU_FIELD_META, DMENU_NUM_FIELDS };
+
+/**
+ * @param pd The dmenu private data.
+ * @param index The row.
+ *
+ * @returns the optional fields of the row, or NULL if it has none.
+ */
+static inline DmenuScriptEntry *
+dmenu_get_extras(const DmenuModePrivateData *pd, unsigned int index) {
+  uint32_t extras = pd->cmd_list[index].extras;
+  if (extras == 0) {
+    return NULL;
+  }
+  return &g_array_index(pd->extras, DmenuScriptEntry, extras - 1);
+}
+
+/**
+ * @param pd The dmenu private data.
+ * @param index The row.
+ * @param len Set to the length of the returned text in bytes.
+ *
+ * @returns the entry of the row stripped from markup, or NULL if the markup
+ * is invalid. The text is not NUL terminated when it is in the mapping.
+ */
+static inline const char *dmenu_get_text(const DmenuModePrivateData *pd,
+                                         unsigned int index, gsize *len) {
+  const DmenuRow *row = &(pd->cmd_list[index]);
+  if (row->stripped == 0) {
+    *len = row->length;
+    return row->entry;
+  }
+  if (row->stripped == UINT32_MAX) {
+    *len = 0;
+    return NULL;
+  }
+  const char *text = g_ptr_array_index(pd->stripped, row->stripped - 1);
+  *len = strlen(text);
+  return text;
+}
+
+/**
+ * @param pd The dmenu private data.
+ * @param index The row.
+ * @param len Set to the length of the returned text in bytes.
+ *
+ * @returns the text to display for the row, not NUL terminated when it is
+ * in the mapping.
+ */
+static const char *dmenu_get_display(const DmenuModePrivateData *pd,
+                                     unsigned int index, gsize *len) {
+  const DmenuScriptEntry *extras = dmenu_get_extras(pd, index);
+  if (extras != NULL && extras->display != NULL) {
+    *len = strlen(extras->display);
+    return extras->display;
+  }
+  *len = pd->cmd_list[index].length;
+  return pd->cmd_list[index].entry;
+}
+
+/**
+ * @param pd The dmenu private data.
+ * @param str The text of a row.
+ *
+ * @returns TRUE if str points into the mapped -input file, and so is not
+ * NUL terminated.
+ */
+static inline gboolean dmenu_in_map(const DmenuModePrivateData *pd,
+                                    const char *str) {
+  return pd->map != NULL && str >= pd->map && str < pd->map + pd->map_len;
+}
+
+/**
+ * @param pd The dmenu private data.
+ *
+ * With -display-columns, split the display text of the rows added since the
+ * previous call in columns and keep the spans of the selected columns. The
+ * text is split like g_regex_split() does, including the substrings captured
+ * by the separator, but empty separators are ignored.
+ */
+static void dmenu_split_columns(DmenuModePrivateData *pd) {
+  if (pd->columns == NULL || pd->num_columns == 0) {
+    return;
+  }
+  unsigned int *numbers = g_new(unsigned int, pd->num_columns);
+  for (unsigned int i = 0; i < pd->num_columns; i++) {
+    numbers[i] = (unsigned int)g_ascii_strtoull(pd->columns[i], NULL, 10);
+  }
+  GArray *fields = g_array_new(FALSE, FALSE, sizeof(DmenuColumnSpan));
+  for (unsigned int row = pd->column_spans->len / pd->num_columns;
+       row < pd->cmd_list_length; row++) {
+    gsize len = 0;
+    const char *text = dmenu_get_display(pd, row, &len);
+    g_array_set_size(fields, 0);
+    if (pd->column_regex != NULL && len > 0) {
+      GMatchInfo *match_info = NULL;
+      gint start = 0;
+      g_regex_match_full(pd->column_regex, text, len, 0, 0, &match_info,
+                         NULL);
+      while (g_match_info_matches(match_info)) {
+        gint match_start, match_end;
+        g_match_info_fetch_pos(match_info, 0, &match_start, &match_end);
+        if (match_end > match_start) {
+          DmenuColumnSpan field = {start, match_start - start};
+          g_array_append_val(fields, field);
+          start = match_end;
+          // Like g_regex_split(), the captured substrings are fields too.
+          gint count = g_match_info_get_match_count(match_info);
+          for (gint group = 1; group < count; group++) {
+            gint group_start, group_end;
+            g_match_info_fetch_pos(match_info, group, &group_start,
+                                   &group_end);
+            DmenuColumnSpan capture = {match_start, 0};
+            if (group_start >= 0) {
+              capture.start = group_start;
+              capture.len = group_end - group_start;
+            }
+            g_array_append_val(fields, capture);
+          }
+        }
+        g_match_info_next(match_info, NULL);
+      }
+      g_match_info_free(match_info);
+      DmenuColumnSpan field = {start, len - start};
+      g_array_append_val(fields, field);
+    }
+    for (unsigned int i = 0; i < pd->num_columns; i++) {
+      DmenuColumnSpan span = {0, UINT32_MAX};
+      if (numbers[i] > 0 && numbers[i] <= fields->len) {
+        span = g_array_index(fields, DmenuColumnSpan, numbers[i] - 1);
+      }
+      g_array_append_val(pd->column_spans, span);
+    }
+  }
+  g_array_free(fields, TRUE);
+  g_free(numbers);
+}
+
+/**
+ * @param arena The string arena.
+ * @param str The string to move into the arena (or NULL), freed.
+ *
+ * @returns the copy of str in the arena.
+ */
+static char *dmenu_arena_take(RofiStringArena *arena, char *str) {
+  if (str == NULL) {
+    return NULL;
+  }
+  char *retv = helper_string_arena_add(arena, str, -1);
+  g_free(str);
+  return retv;
+}
+
+/**
+ * @param pd The dmenu private data.
+ * @param row The next row.
+ * @param extras The side table holding the optional fields of row (or NULL
+ * if it has none).
+ *
+ * Add the matchable fields of the next row to the trigram index, if enabled.
+ */
+static void dmenu_index_row(DmenuModePrivateData *pd, const DmenuRow *row,
+                            const GArray *extras) {
+  if (pd->trigram_index != NULL) {
+    const char *meta = NULL;
+    if (row->extras > 0) {
+      meta = g_array_index(extras, DmenuScriptEntry, row->extras - 1).meta;
+    }
+    helper_trigram_index_add(pd->trigram_index, pd->trigram_rows, row->entry,
+                             row->length);
+    helper_trigram_index_add(pd->trigram_index, pd->trigram_rows, meta, -1);
+    pd->trigram_rows++;
+  }
+}
+
+/**
+ * @param arena The string arena to copy the stripped entry into.
+ * @param row The row.
+ * @param stripped The side table to add the stripped entry to, created when
+ * needed.
+ *
+ * Strip the markup from the entry of the row once, instead of on every
+ * filter pass.
+ */
+static void dmenu_strip_row(RofiStringArena *arena, DmenuRow *row,
+                            GPtrArray **stripped) {
+  char *text = NULL;
+  row->stripped = 0;
+  if (!pango_parse_markup(row->entry, row->length, 0, NULL, &text, NULL,
+                          NULL)) {
+    row->stripped = UINT32_MAX;
+    return;
+  }
+  if (strlen(text) != row->length ||
+      memcmp(text, row->entry, row->length) != 0) {
+    if (*stripped == NULL) {
+      *stripped = g_ptr_array_new();
+    }
+    g_ptr_array_add(*stripped, helper_string_arena_add(arena, text, -1));
+    row->stripped = (*stripped)->len;
+  }
+  g_free(text);
+}
+
+/**
+ * @param arena The string arena to copy the strings into.
+ * @param row The row to fill.
+ * @param extras The side table to add the optional fields of the row to,
+ * created when needed.
+ * @param stripped The side table for the entry stripped from markup, or NULL
+ * without -markup-rows.
+ * @param data The line, the optional fields follow after a NUL.
+ * @param len The length of data in bytes.
+ *
+ * Parse a line of input. With async input this runs on the reading thread,
+ * or on the thread pool.
+ */
+static void dmenu_parse_row(RofiStringArena *arena, DmenuRow *row,
+                            GArray **extras, GPtrArray **stripped, char *data,
+                            gsize len) {
+  gsize data_len = len;
+  char *end = memchr(data, '\0', len);
+  row->extras = 0;
+  if (end != NULL) {
+    data_len = end - data;
+    DmenuScriptEntry extra = {.entry = NULL};
+    dmenuscript_parse_entry_extras(NULL, &extra, end + 1, len - data_len);
+    extra.display = dmenu_arena_take(arena, extra.display);
+    extra.icon_name = dmenu_arena_take(arena, extra.icon_name);
+    extra.meta = dmenu_arena_take(arena, extra.meta);
+    extra.info = dmenu_arena_take(arena, extra.info);
+    if (*extras == NULL) {
+      *extras = g_array_new(FALSE, FALSE, sizeof(DmenuScriptEntry));
+    }
+    g_array_append_val(*extras, extra);
+    row->extras = (*extras)->len;
+  }
+  row->entry = helper_string_arena_add_utf8(arena, data, data_len);
+  row->length = strlen(row->entry);
+  row->stripped = 0;
+  if (stripped != NULL) {
+    dmenu_strip_row(arena, row, stripped);
+  }
+}
+
 /** Maximum number of lines rofi parses async before it pushes it to the main
  * thread. */
 #define BLOCK_LINES_SIZE 2048
 typedef struct {
   unsigned int length;
-  DmenuScriptEntry values[BLOCK_LINES_SIZE];
+  DmenuRow values[BLOCK_LINES_SIZE];
+  /** The optional fields of the rows, indexed from the start of the block.
+   */
+  GArray *extras;
+  /** The stripped entries of the rows, indexed from the start of the block.
+   */
+  GPtrArray *stripped;
   DmenuModePrivateData *pd;
 } Block;
 
+static void block_free(Block *block) {
+  if (block->extras != NULL) {
+    g_array_free(block->extras, TRUE);
+  }
+  if (block->stripped != NULL) {
+    g_ptr_array_free(block->stripped, TRUE);
+  }
+  g_free(block);
+}
+
 static void read_add_block(DmenuModePrivateData *pd, Block **block, char *data,
                            gsize len) {
 
@@ -131,62 +449,25 @@ static void read_add_block(DmenuModePrivateData *pd, Block **block, char *data,
     (*block)->pd = pd;
     (*block)->length = 0;
   }
-  gsize data_len = len;
-  // Init.
-  (*block)->values[(*block)->length].icon_fetch_uid = 0;
-  (*block)->values[(*block)->length].icon_fetch_size = 0;
-  (*block)->values[(*block)->length].icon_name = NULL;
-  (*block)->values[(*block)->length].meta = NULL;
-  (*block)->values[(*block)->length].info = NULL;
-  (*block)->values[(*block)->length].nonselectable = FALSE;
-  (*block)->values[(*block)->length].permanent = FALSE;
-  char *end = data;
-  while (end < data + len && *end != '\0') {
-    end++;
-  }
-  if (end != data + len) {
-    data_len = end - data;
-    dmenuscript_parse_entry_extras(NULL, &((*block)->values[(*block)->length]),
-                                   end + 1, len - data_len);
-  }
-  char *utfstr = rofi_force_utf8(data, data_len);
-  (*block)->values[(*block)->length].entry = utfstr;
-  (*block)->values[(*block)->length + 1].entry = NULL;
-
+  DmenuRow *row = &((*block)->values[(*block)->length]);
+  dmenu_parse_row(pd->arena, row, &((*block)->extras),
+                  pd->do_markup ? &((*block)->stripped) : NULL, data, len);
+  dmenu_index_row(pd, row, (*block)->extras);
   (*block)->length++;
 }
 
 static void read_add(DmenuModePrivateData *pd, char *data, gsize len) {
-  gsize data_len = len;
-  if ((pd->cmd_list_length + 2) > pd->cmd_list_real_length) {
+  if ((pd->cmd_list_length + 1) > pd->cmd_list_real_length) {
     pd->cmd_list_real_length = MAX(pd->cmd_list_real_length * 2, 512);
-    pd->cmd_list = g_realloc(pd->cmd_list, (pd->cmd_list_real_length) *
-                                               sizeof(DmenuScriptEntry));
-  }
-  // Init.
-  pd->cmd_list[pd->cmd_list_length].icon_fetch_uid = 0;
-  pd->cmd_list[pd->cmd_list_length].icon_fetch_size = 0;
-  pd->cmd_list[pd->cmd_list_length].icon_name = NULL;
-  pd->cmd_list[pd->cmd_list_length].display = NULL;
-  pd->cmd_list[pd->cmd_list_length].meta = NULL;
-  pd->cmd_list[pd->cmd_list_length].info = NULL;
-  pd->cmd_list[pd->cmd_list_length].active = FALSE;
-  pd->cmd_list[pd->cmd_list_length].urgent = FALSE;
-  pd->cmd_list[pd->cmd_list_length].nonselectable = FALSE;
-  char *end = data;
-  while (end < data + len && *end != '\0') {
-    end++;
-  }
-  if (end != data + len) {
-    data_len = end - data;
-    dmenuscript_parse_entry_extras(NULL, &(pd->cmd_list[pd->cmd_list_length]),
-                                   end + 1, len - data_len);
+    pd->cmd_list = g_realloc_n(pd->cmd_list, pd->cmd_list_real_length,
+                               sizeof(DmenuRow));
   }
-  char *utfstr = rofi_force_utf8(data, data_len);
-  pd->cmd_list[pd->cmd_list_length].entry = utfstr;
-  pd->cmd_list[pd->cmd_list_length + 1].entry = NULL;
-
+  DmenuRow *row = &(pd->cmd_list[pd->cmd_list_length]);
+  dmenu_parse_row(pd->arena, row, &(pd->extras),
+                  pd->do_markup ? &(pd->stripped) : NULL, data, len);
+  dmenu_index_row(pd, row, pd->extras);
   pd->cmd_list_length++;
+  helper_haystack_cache_resize(pd->haystack, pd->cmd_list_length);
 }
 
 /**
@@ -211,23 +492,60 @@ static gboolean dmenu_async_read_proc(gint fd, GIOCondition condition,
     if (command == 'r') {
       Block *block = NULL;
       gboolean changed = FALSE;
+      // The list is about to grow, filtering should not read it. The pass
+      // continues after, the appended rows are filtered once it is done.
+      rofi_view_filter_pause();
       // Empty out the AsyncQueue (that is thread safe) from all blocks pushed
       // into it.
       while ((block = g_async_queue_try_pop(pd->async_queue)) != NULL) {
 
         if (pd->cmd_list_real_length < (pd->cmd_list_length + block->length)) {
-          pd->cmd_list_real_length = MAX(pd->cmd_list_real_length * 2, 4096);
-          pd->cmd_list = g_realloc(pd->cmd_list, sizeof(DmenuScriptEntry) *
-                                                     pd->cmd_list_real_length);
+          pd->cmd_list_real_length =
+              MAX(MAX(pd->cmd_list_real_length * 2, 4096),
+                  pd->cmd_list_length + block->length);
+          pd->cmd_list = g_realloc_n(pd->cmd_list, pd->cmd_list_real_length,
+                                     sizeof(DmenuRow));
+        }
+        DmenuRow *rows = &(pd->cmd_list[pd->cmd_list_length]);
+        memcpy(rows, &(block->values[0]), sizeof(DmenuRow) * block->length);
+        if (block->extras != NULL) {
+          // Move the optional fields of the block to the end of the table.
+          if (pd->extras == NULL) {
+            pd->extras = g_array_new(FALSE, FALSE, sizeof(DmenuScriptEntry));
+          }
+          uint32_t base = pd->extras->len;
+          g_array_append_vals(pd->extras, block->extras->data,
+                              block->extras->len);
+          for (unsigned int i = 0; i < block->length; i++) {
+            if (rows[i].extras > 0) {
+              rows[i].extras += base;
+            }
+          }
+        }
+        if (block->stripped != NULL) {
+          // Likewise for the stripped entries.
+          if (pd->stripped == NULL) {
+            pd->stripped = g_ptr_array_new();
+          }
+          uint32_t base = pd->stripped->len;
+          g_ptr_array_extend(pd->stripped, block->stripped, NULL, NULL);
+          for (unsigned int i = 0; i < block->length; i++) {
+            if (rows[i].stripped > 0 && rows[i].stripped != UINT32_MAX) {
+              rows[i].stripped += base;
+            }
+          }
         }
-        memcpy(&(pd->cmd_list[pd->cmd_list_length]), &(block->values[0]),
-               sizeof(DmenuScriptEntry) * block->length);
         pd->cmd_list_length += block->length;
-        g_free(block);
+        block_free(block);
         changed = TRUE;
       }
       if (changed) {
-        rofi_view_reload();
+        helper_haystack_cache_resize(pd->haystack, pd->cmd_list_length);
+        dmenu_split_columns(pd);
+      }
+      rofi_view_filter_resume();
+      if (changed) {
+        rofi_view_append_rows();
       }
     } else if (command == 'q') {
       if (pd->loading) {
@@ -254,15 +572,197 @@ static void read_input_sync(DmenuModePrivateData *pd, unsigned int pre_read) {
   free(line);
   return;
 }
+/**
+ * @param pd The dmenu private data.
+ * @param block The block to push (or NULL), reset to NULL.
+ *
+ * Hand the block to the main thread.
+ */
+static void read_push_block(DmenuModePrivateData *pd, Block **block) {
+  if (*block == NULL) {
+    return;
+  }
+  g_async_queue_push(pd->async_queue, *block);
+  *block = NULL;
+  write(pd->pipefd2[1], "r", 1);
+}
+
+/** Number of bytes rofi reads from the input at once. */
+#define READ_BUFFER_SIZE (256 * 1024)
+
+/** State of the reading thread when rows are parsed on the thread pool. */
+typedef struct {
+  /** The dmenu private data. */
+  DmenuModePrivateData *pd;
+  /** Parses the chunks. Not the shared pool of the view, that one is
+   * replaced from the main thread when the page changes, dropping the
+   * queued work. */
+  GThreadPool *pool;
+  /** The chunks handed to the pool, in input order. */
+  GQueue pending;
+  /** Maximum number of pending chunks. */
+  unsigned int max_pending;
+  /** Lock for the done flag of the chunks. */
+  GMutex mutex;
+  /** Signalled when a chunk is done. */
+  GCond cond;
+} ReadPipeline;
+
+/** A chunk of input, parsed in blocks by a worker. */
+typedef struct {
+  /** The pipeline. */
+  ReadPipeline *rp;
+  /** The rows, each ends with the separator except the last at the end of
+   * the chunk. Has room for one more byte. */
+  char *data;
+  /** Length of data in bytes. */
+  gsize len;
+  /** Holds the strings of the rows, until merged into the arena of pd. */
+  RofiStringArena *arena;
+  /** The parsed rows, as array of #Block. */
+  GPtrArray *blocks;
+  /** Set when the worker is done, protected by the mutex of rp. */
+  gboolean done;
+} ReadChunk;
+
+/**
+ * @param data The #ReadChunk.
+ * @param user_data Unused.
+ *
+ * Split the chunk in rows and parse them in blocks.
+ */
+static void read_chunk_parse(gpointer data, G_GNUC_UNUSED gpointer user_data) {
+  ReadChunk *chunk = (ReadChunk *)data;
+  ReadPipeline *rp = chunk->rp;
+  char *iter = chunk->data;
+  char *end = chunk->data + chunk->len;
+  Block *block = NULL;
+  while (iter < end) {
+    char *sep = memchr(iter, rp->pd->separator, end - iter);
+    if (sep == NULL) {
+      sep = end;
+    }
+    *sep = '\0';
+    if (block == NULL || block->length == BLOCK_LINES_SIZE) {
+      block = g_malloc0(sizeof(Block));
+      block->pd = rp->pd;
+      g_ptr_array_add(chunk->blocks, block);
+    }
+    dmenu_parse_row(chunk->arena, &(block->values[block->length]),
+                    &(block->extras),
+                    rp->pd->do_markup ? &(block->stripped) : NULL, iter,
+                    sep - iter);
+    block->length++;
+    iter = sep + 1;
+  }
+  g_mutex_lock(&(rp->mutex));
+  chunk->done = TRUE;
+  g_cond_broadcast(&(rp->cond));
+  g_mutex_unlock(&(rp->mutex));
+}
+
+/**
+ * @param rp The pipeline.
+ * @param push If the rows should be handed to the main thread, or dropped.
+ *
+ * Wait for the oldest chunk and hand its blocks to the main thread in order.
+ */
+static void read_chunk_collect(ReadPipeline *rp, gboolean push) {
+  DmenuModePrivateData *pd = rp->pd;
+  ReadChunk *chunk = g_queue_pop_head(&(rp->pending));
+  g_mutex_lock(&(rp->mutex));
+  while (!chunk->done) {
+    g_cond_wait(&(rp->cond), &(rp->mutex));
+  }
+  g_mutex_unlock(&(rp->mutex));
+  helper_string_arena_merge(pd->arena, chunk->arena);
+  for (guint i = 0; i < chunk->blocks->len; i++) {
+    Block *block = g_ptr_array_index(chunk->blocks, i);
+    if (!push) {
+      block_free(block);
+      continue;
+    }
+    for (unsigned int j = 0; j < block->length; j++) {
+      dmenu_index_row(pd, &(block->values[j]), block->extras);
+    }
+    read_push_block(pd, &block);
+  }
+  g_ptr_array_free(chunk->blocks, TRUE);
+  g_free(chunk->data);
+  g_free(chunk);
+}
+
+/**
+ * @param rp The pipeline.
+ * @param push If the rows should be handed to the main thread, or dropped.
+ *
+ * Wait for all pending chunks.
+ */
+static void read_pipeline_flush(ReadPipeline *rp, gboolean push) {
+  while (!g_queue_is_empty(&(rp->pending))) {
+    read_chunk_collect(rp, push);
+  }
+}
+
+/**
+ * @param rp The pipeline.
+ * @param line The read buffer, the rows are taken and a new buffer with the
+ * remaining bytes is put in its place.
+ * @param len The size of the read buffer.
+ * @param nread The number of bytes in the read buffer, updated.
+ * @param rows The number of bytes of rows at the start of the buffer.
+ *
+ * Hand the rows at the start of the read buffer to the thread pool.
+ */
+static void read_chunk_dispatch(ReadPipeline *rp, char **line, size_t len,
+                                size_t *nread, size_t rows) {
+  ReadChunk *chunk = g_malloc0(sizeof(ReadChunk));
+  chunk->rp = rp;
+  chunk->data = *line;
+  chunk->len = rows;
+  chunk->arena = helper_string_arena_new();
+  chunk->blocks = g_ptr_array_new();
+  *nread -= rows;
+  *line = g_malloc(len);
+  memcpy(*line, chunk->data + rows, *nread);
+  g_queue_push_tail(&(rp->pending), chunk);
+  g_thread_pool_push(rp->pool, chunk, NULL);
+  while (rp->pending.length >= rp->max_pending) {
+    read_chunk_collect(rp, TRUE);
+  }
+}
+
 static gpointer read_input_thread(gpointer userdata) {
   DmenuModePrivateData *pd = (DmenuModePrivateData *)userdata;
-  ssize_t nread = 0;
-  ssize_t len = 0;
-  char *line = NULL;
+  // Bytes in the buffer, the start of a row that is not complete yet.
+  size_t nread = 0;
+  size_t len = READ_BUFFER_SIZE;
+  char *line = g_malloc(len);
   Block *block = NULL;
+  // With more threads, the rows are parsed on the thread pool in chunks.
+  ReadPipeline *rp = NULL;
+  // Bytes of complete rows at the start of the buffer, for the pipeline.
+  size_t rows = 0;
+  if (config.threads > 1) {
+    GError *error = NULL;
+    GThreadPool *pool = g_thread_pool_new(read_chunk_parse, NULL,
+                                          config.threads, FALSE, &error);
+    if (error != NULL) {
+      g_warning("Failed to create the read thread pool: %s", error->message);
+      g_error_free(error);
+    } else {
+      rp = g_malloc0(sizeof(ReadPipeline));
+      rp->pd = pd;
+      rp->pool = pool;
+      rp->max_pending = 2 * config.threads;
+      g_mutex_init(&(rp->mutex));
+      g_cond_init(&(rp->cond));
+    }
+  }
 
   GTimer *tim = g_timer_new();
   int fd = pd->fd;
+  gboolean aborted = FALSE;
   while (1) {
     // Wait for input from the input or from the main thread.
     fd_set rfds;
@@ -280,76 +780,299 @@ static gpointer read_input_thread(gpointer userdata) {
     } else if (retval) {
       // We get input from the UI thread, this is always an abort.
       if (FD_ISSET(pd->pipefd[0], &rfds)) {
+        aborted = TRUE;
         break;
       }
       //  Input data is available.
       if (FD_ISSET(fd, &rfds)) {
-        ssize_t readbytes = 0;
-        if ((nread + 1024) > len) {
-          line = g_realloc(line, (nread + 1024));
-          len = nread + 1024;
+        if ((nread + 1) >= len) {
+          // A row longer than the buffer.
+          len *= 2;
+          line = g_realloc(line, len);
         }
-        readbytes = read(fd, &line[nread], 1023);
-        if (readbytes > 0) {
+        ssize_t readbytes = read(fd, &line[nread], len - nread - 1);
+        if (readbytes > 0 && rp != NULL) {
+          // Only the new bytes can hold a separator.
+          char *last = memrchr(&line[nread], pd->separator, readbytes);
           nread += readbytes;
-          line[nread] = '\0';
-          ssize_t i = 0;
-          while (i < nread) {
-            if (line[i] == pd->separator) {
-              line[i] = '\0';
-              read_add_block(pd, &block, line, i);
-              memmove(&line[0], &line[i + 1], nread - (i + 1));
-              nread -= (i + 1);
-              i = 0;
-              if (block) {
-                double elapsed = g_timer_elapsed(tim, NULL);
-                if (elapsed >= 0.1 || block->length == BLOCK_LINES_SIZE) {
-                  g_timer_start(tim);
-                  g_async_queue_push(pd->async_queue, block);
-                  block = NULL;
-                  write(pd->pipefd2[1], "r", 1);
-                }
-              }
-            } else {
-              i++;
+          if (last != NULL) {
+            rows = last + 1 - line;
+          }
+          gboolean flush = g_timer_elapsed(tim, NULL) >= 0.1;
+          if (rows > 0 && (rows >= len / 2 || flush)) {
+            read_chunk_dispatch(rp, &line, len, &nread, rows);
+            rows = 0;
+          }
+          if (flush) {
+            read_pipeline_flush(rp, TRUE);
+            g_timer_start(tim);
+          }
+        } else if (readbytes > 0) {
+          // Only the new bytes can hold a separator.
+          char *start = line;
+          char *iter = &line[nread];
+          char *end = &line[nread + readbytes];
+          char *sep;
+          while ((sep = memchr(iter, pd->separator, end - iter)) != NULL) {
+            *sep = '\0';
+            read_add_block(pd, &block, start, sep - start);
+            if (block->length == BLOCK_LINES_SIZE) {
+              g_timer_start(tim);
+              read_push_block(pd, &block);
             }
+            start = iter = sep + 1;
+          }
+          // Keep the incomplete last row for the next read.
+          nread = end - start;
+          if (start != line && nread > 0) {
+            memmove(line, start, nread);
+          }
+          if (block != NULL && g_timer_elapsed(tim, NULL) >= 0.1) {
+            g_timer_start(tim);
+            read_push_block(pd, &block);
           }
         } else {
           // remainder in buffer, then quit.
-          if (nread > 0) {
+          if (nread > 0 && rp != NULL) {
+            read_chunk_dispatch(rp, &line, len, &nread, nread);
+          } else if (nread > 0) {
             line[nread] = '\0';
             read_add_block(pd, &block, line, nread);
           }
-          if (block) {
-            g_timer_start(tim);
-            g_async_queue_push(pd->async_queue, block);
-            block = NULL;
-            write(pd->pipefd2[1], "r", 1);
-          }
+          g_timer_start(tim);
+          read_push_block(pd, &block);
           break;
         }
       }
     } else {
       // Timeout, pushout remainder data.
-      if (nread > 0) {
+      if (rp != NULL) {
+        if (nread > 0) {
+          read_chunk_dispatch(rp, &line, len, &nread, nread);
+          rows = 0;
+        }
+        read_pipeline_flush(rp, TRUE);
+      } else if (nread > 0) {
         line[nread] = '\0';
         read_add_block(pd, &block, line, nread);
         nread = 0;
       }
       if (block) {
         g_timer_start(tim);
-        g_async_queue_push(pd->async_queue, block);
-        block = NULL;
-        write(pd->pipefd2[1], "r", 1);
+        read_push_block(pd, &block);
       }
     }
   }
+  if (rp != NULL) {
+    // The rows are dropped when the main thread gave up on them.
+    read_pipeline_flush(rp, !aborted);
+    g_thread_pool_free(rp->pool, FALSE, TRUE);
+    g_mutex_clear(&(rp->mutex));
+    g_cond_clear(&(rp->cond));
+    g_free(rp);
+  }
   g_timer_destroy(tim);
-  free(line);
+  g_free(line);
   write(pd->pipefd2[1], "q", 1);
   return NULL;
 }
 
+/** Bytes of a mapped -input file per chunk of indexing work. */
+#define MAP_CHUNK_SIZE (4 * 1024 * 1024)
+
+/** State of indexing a mapped -input file, shared by all chunks. */
+typedef struct {
+  /** Row separator. */
+  char separator;
+  /** Lock for the done flag of the chunks. */
+  GMutex mutex;
+  /** Signalled when a chunk is done. */
+  GCond cond;
+} DmenuMap;
+
+/** A chunk of a mapped -input file, split in rows by a worker. */
+typedef struct {
+  /** Generic thread state. */
+  thread_state st;
+  /** The shared state. */
+  DmenuMap *shared;
+  /** The rows, each ends with the separator except the last at the end of
+   * the mapping. */
+  const char *data;
+  /** Length of data in bytes. */
+  gsize len;
+  /** Array of #DmenuRow, see dmenu_map_chunk_index(). */
+  GArray *rows;
+  /** Lengths of the rows that still have to be parsed. */
+  GArray *lengths;
+  /** Set when the worker is done, protected by the mutex of shared. */
+  gboolean done;
+} DmenuMapChunk;
+
+/**
+ * @param ts The #DmenuMapChunk.
+ * @param user_data Unused.
+ *
+ * Split the chunk in rows, without writing to it. Rows that are valid UTF-8
+ * without optional fields point into the mapping with their length. The
+ * others get extras set to UINT32_MAX, they are parsed on the main thread
+ * by dmenu_map_chunk_collect().
+ */
+static void dmenu_map_chunk_index(thread_state *ts,
+                                  G_GNUC_UNUSED gpointer user_data) {
+  DmenuMapChunk *chunk = (DmenuMapChunk *)ts;
+  DmenuMap *shared = chunk->shared;
+  const char *iter = chunk->data;
+  const char *end = chunk->data + chunk->len;
+  while (iter < end) {
+    const char *line_end = memchr(iter, shared->separator, end - iter);
+    gsize len = ((line_end != NULL) ? line_end : end) - iter;
+    DmenuRow row = {.entry = iter, .length = len, .extras = 0};
+    // Validation also fails on the NUL that starts the optional fields.
+    if (len > G_MAXUINT32 || !g_utf8_validate(iter, len, NULL)) {
+      row.extras = UINT32_MAX;
+      g_array_append_val(chunk->lengths, len);
+    }
+    g_array_append_val(chunk->rows, row);
+    iter += len + 1;
+  }
+  g_mutex_lock(&(shared->mutex));
+  chunk->done = TRUE;
+  g_cond_broadcast(&(shared->cond));
+  g_mutex_unlock(&(shared->mutex));
+}
+
+/**
+ * @param pd The dmenu private data.
+ * @param shared The shared state.
+ * @param chunk The oldest chunk, freed.
+ *
+ * Wait for the chunk and append its rows.
+ */
+static void dmenu_map_chunk_collect(DmenuModePrivateData *pd, DmenuMap *shared,
+                                    DmenuMapChunk *chunk) {
+  g_mutex_lock(&(shared->mutex));
+  while (!chunk->done) {
+    g_cond_wait(&(shared->cond), &(shared->mutex));
+  }
+  g_mutex_unlock(&(shared->mutex));
+  unsigned int length = chunk->rows->len;
+  if (pd->cmd_list_real_length < (pd->cmd_list_length + length)) {
+    pd->cmd_list_real_length = MAX(MAX(pd->cmd_list_real_length * 2, 4096),
+                                   pd->cmd_list_length + length);
+    pd->cmd_list =
+        g_realloc_n(pd->cmd_list, pd->cmd_list_real_length, sizeof(DmenuRow));
+  }
+  guint parsed = 0;
+  for (unsigned int i = 0; i < length; i++) {
+    DmenuRow *row = &(pd->cmd_list[pd->cmd_list_length + i]);
+    *row = g_array_index(chunk->rows, DmenuRow, i);
+    if (row->extras != UINT32_MAX) {
+      if (pd->do_markup) {
+        dmenu_strip_row(pd->arena, row, &(pd->stripped));
+      }
+      dmenu_index_row(pd, row, NULL);
+      continue;
+    }
+    // The optional fields are parsed from a NUL terminated copy.
+    gsize len = g_array_index(chunk->lengths, gsize, parsed++);
+    char *copy = g_malloc(len + 1);
+    memcpy(copy, row->entry, len);
+    copy[len] = '\0';
+    dmenu_parse_row(pd->arena, row, &(pd->extras),
+                    pd->do_markup ? &(pd->stripped) : NULL, copy, len);
+    g_free(copy);
+    dmenu_index_row(pd, row, pd->extras);
+  }
+  pd->cmd_list_length += length;
+  g_array_free(chunk->rows, TRUE);
+  g_array_free(chunk->lengths, TRUE);
+  g_free(chunk);
+}
+
+/**
+ * @param pd The dmenu private data.
+ * @param path The -input file.
+ *
+ * Map a regular -input file in memory, instead of reading it, and split it
+ * in rows in chunks on the thread pool. The mapping is read only, the rows
+ * point into it and keep their length. Rows with optional fields or invalid
+ * UTF-8 are parsed into the string arena.
+ *
+ * @returns FALSE if the file can not be mapped and has to be read.
+ */
+static gboolean dmenu_map_input(DmenuModePrivateData *pd, const char *path) {
+  char *estr = rofi_expand_path(path);
+  int fd = open(estr, O_RDONLY | O_CLOEXEC);
+  g_free(estr);
+  if (fd == -1) {
+    return FALSE;
+  }
+  struct stat sb;
+  if (fstat(fd, &sb) == -1 || !S_ISREG(sb.st_mode) || sb.st_size <= 0 ||
+      (guint64)sb.st_size > G_MAXSIZE) {
+    close(fd);
+    return FALSE;
+  }
+  char *data = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    g_debug("Failed to map the input file: %s", g_strerror(errno));
+    close(fd);
+    return FALSE;
+  }
+  close(fd);
+  pd->map = data;
+  pd->map_len = sb.st_size;
+
+  GTimer *timer = g_timer_new();
+  DmenuMap shared = {.separator = pd->separator};
+  g_mutex_init(&(shared.mutex));
+  g_cond_init(&(shared.cond));
+  GQueue pending = G_QUEUE_INIT;
+  // Bound the work ahead, so the row arrays are merged as they come in.
+  unsigned int max_pending = 2 * MAX(1, config.threads);
+  char *iter = pd->map;
+  char *end = pd->map + pd->map_len;
+  while (iter < end) {
+    char *chunk_end = end;
+    if ((gsize)(end - iter) > MAP_CHUNK_SIZE) {
+      // End the chunk after a separator.
+      char *last = iter + MAP_CHUNK_SIZE - 1;
+      char *sep = memchr(last, pd->separator, end - last);
+      chunk_end = (sep != NULL) ? sep + 1 : end;
+    }
+    DmenuMapChunk *chunk = g_malloc0(sizeof(DmenuMapChunk));
+    chunk->st.callback = dmenu_map_chunk_index;
+    chunk->st.priority = G_PRIORITY_HIGH;
+    chunk->shared = &shared;
+    chunk->data = iter;
+    chunk->len = chunk_end - iter;
+    chunk->rows = g_array_new(FALSE, FALSE, sizeof(DmenuRow));
+    chunk->lengths = g_array_new(FALSE, FALSE, sizeof(gsize));
+    g_queue_push_tail(&pending, chunk);
+    if (config.threads > 1) {
+      g_thread_pool_push(tpool, chunk, NULL);
+    } else {
+      dmenu_map_chunk_index((thread_state *)chunk, NULL);
+    }
+    while (pending.length >= max_pending) {
+      dmenu_map_chunk_collect(pd, &shared, g_queue_pop_head(&pending));
+    }
+    iter = chunk_end;
+  }
+  while (!g_queue_is_empty(&pending)) {
+    dmenu_map_chunk_collect(pd, &shared, g_queue_pop_head(&pending));
+  }
+  helper_haystack_cache_resize(pd->haystack, pd->cmd_list_length);
+  g_debug("Mapped %u rows (%.1f MiB) of the input file in %.3f s.",
+          pd->cmd_list_length, pd->map_len / (1024.0 * 1024.0),
+          g_timer_elapsed(timer, NULL));
+  g_timer_destroy(timer);
+  g_mutex_clear(&(shared.mutex));
+  g_cond_clear(&(shared.cond));
+  return TRUE;
+}
+
 static unsigned int dmenu_mode_get_num_entries(const Mode *sw) {
   const DmenuModePrivateData *rmpd =
       (const DmenuModePrivateData *)mode_get_private_data(sw);
@@ -358,26 +1081,22 @@ static unsigned int dmenu_mode_get_num_entries(const Mode *sw) {
 }
 
 static gchar *dmenu_format_output_string(const DmenuModePrivateData *pd,
-                                         const char *input,
+                                         const char *input, gsize len,
                                          const unsigned int index,
                                          gboolean multi_select) {
   if (pd->columns == NULL) {
     if (multi_select) {
       if (pd->selected_list && bitget(pd->selected_list, index) == TRUE) {
-        return g_strdup_printf("%s%s", pd->ballot_selected, input);
+        return g_strdup_printf("%s%.*s", pd->ballot_selected, (int)len,
+                               input);
       } else {
-        return g_strdup_printf("%s%s", pd->ballot_unselected, input);
+        return g_strdup_printf("%s%.*s", pd->ballot_unselected, (int)len,
+                               input);
       }
     }
-    return g_strdup(input);
+    return g_strndup(input, len);
   }
   char *retv = NULL;
-  char **splitted =
-      g_regex_split_simple(pd->column_separator, input, G_REGEX_CASELESS, 00);
-  uint32_t ns = 0;
-  for (; splitted && splitted[ns]; ns++) {
-    ;
-  }
   GString *str_retv = g_string_new("");
 
   if (multi_select) {
@@ -387,19 +1106,17 @@ static gchar *dmenu_format_output_string(const DmenuModePrivateData *pd,
       g_string_append(str_retv, pd->ballot_unselected);
     }
   }
-  for (uint32_t i = 0; pd->columns && pd->columns[i]; i++) {
-    unsigned int col_index =
-        (unsigned int)g_ascii_strtoull(pd->columns[i], NULL, 10);
-    if (col_index <= ns && col_index > 0) {
-      if (i == 0) {
-        g_string_append(str_retv, splitted[col_index - 1]);
-      } else {
+  // The columns of input were split when the row was read.
+  for (uint32_t i = 0; i < pd->num_columns; i++) {
+    const DmenuColumnSpan *span = &g_array_index(
+        pd->column_spans, DmenuColumnSpan, (gsize)index * pd->num_columns + i);
+    if (span->len != UINT32_MAX) {
+      if (i > 0) {
         g_string_append_c(str_retv, '\t');
-        g_string_append(str_retv, splitted[col_index - 1]);
       }
+      g_string_append_len(str_retv, input + span->start, span->len);
     }
   }
-  g_strfreev(splitted);
   retv = str_retv->str;
   g_string_free(str_retv, FALSE);
   return retv;
@@ -419,19 +1136,42 @@ static inline unsigned int get_index(unsigned int length, int index) {
 static char *dmenu_get_completion_data(const Mode *data, unsigned int index) {
   Mode *sw = (Mode *)data;
   DmenuModePrivateData *pd = (DmenuModePrivateData *)mode_get_private_data(sw);
-  DmenuScriptEntry *retv = (DmenuScriptEntry *)pd->cmd_list;
-  if (retv[index].display) {
-    return dmenu_format_output_string(pd, retv[index].display, index, FALSE);
-  } else {
-    return dmenu_format_output_string(pd, retv[index].entry, index, FALSE);
+  gsize len = 0;
+  const char *display = dmenu_get_display(pd, index, &len);
+  return dmenu_format_output_string(pd, display, len, index, FALSE);
+}
+
+static const char *dmenu_peek_completion(const Mode *data,
+                                         unsigned int index) {
+  const DmenuModePrivateData *pd =
+      (const DmenuModePrivateData *)mode_get_private_data(data);
+  gsize len = 0;
+  const char *display = dmenu_get_display(pd, index, &len);
+  if (dmenu_in_map(pd, display)) {
+    // Not NUL terminated, formatted per row.
+    return NULL;
+  }
+  if (pd->columns != NULL) {
+    // A single column at the end of the text can be borrowed, others are
+    // formatted per row.
+    const DmenuColumnSpan *span = NULL;
+    if (pd->num_columns == 1) {
+      span = &g_array_index(pd->column_spans, DmenuColumnSpan, index);
+    }
+    if (span == NULL || span->len == UINT32_MAX ||
+        display[span->start + span->len] != '\0') {
+      return NULL;
+    }
+    return display + span->start;
   }
+  return display;
 }
 
 static char *get_display_data(const Mode *data, unsigned int index, int *state,
                               G_GNUC_UNUSED GList **list, int get_entry) {
   Mode *sw = (Mode *)data;
   DmenuModePrivateData *pd = (DmenuModePrivateData *)mode_get_private_data(sw);
-  DmenuScriptEntry *retv = (DmenuScriptEntry *)pd->cmd_list;
+  const DmenuScriptEntry *extras = dmenu_get_extras(pd, index);
   for (unsigned int i = 0; i < pd->num_active_list; i++) {
     unsigned int start =
         get_index(pd->cmd_list_length, pd->active_list[i].start);
@@ -454,23 +1194,19 @@ static char *get_display_data(const Mode *data, unsigned int index, int *state,
   if (pd->do_markup) {
     *state |= MARKUP;
   }
-  if (pd->cmd_list[index].urgent) {
+  if (extras != NULL && extras->urgent) {
     *state |= URGENT;
   }
-  if (pd->cmd_list[index].active) {
+  if (extras != NULL && extras->active) {
     *state |= ACTIVE;
   }
-  char *my_retv = NULL;
-  if (retv[index].display) {
-    my_retv = (get_entry ? dmenu_format_output_string(pd, retv[index].display,
-                                                      index, pd->multi_select)
-                         : NULL);
-  } else {
-    my_retv = (get_entry ? dmenu_format_output_string(pd, retv[index].entry,
-                                                      index, pd->multi_select)
-                         : NULL);
+  if (!get_entry) {
+    return NULL;
   }
-  return my_retv;
+  gsize len = 0;
+  const char *display = dmenu_get_display(pd, index, &len);
+  return dmenu_format_output_string(pd, display, len, index,
+                                    pd->multi_select);
 }
 
 static void dmenu_mode_free(Mode *sw) {
@@ -479,17 +1215,27 @@ static void dmenu_mode_free(Mode *sw) {
   }
   DmenuModePrivateData *pd = (DmenuModePrivateData *)mode_get_private_data(sw);
   if (pd != NULL) {
-
-    for (size_t i = 0; i < pd->cmd_list_length; i++) {
-      if (pd->cmd_list[i].entry) {
-        g_free(pd->cmd_list[i].entry);
-        g_free(pd->cmd_list[i].icon_name);
-        g_free(pd->cmd_list[i].display);
-        g_free(pd->cmd_list[i].meta);
-        g_free(pd->cmd_list[i].info);
-      }
-    }
+    // All strings are in the arena.
     g_free(pd->cmd_list);
+    if (pd->extras != NULL) {
+      g_array_free(pd->extras, TRUE);
+    }
+    if (pd->stripped != NULL) {
+      g_ptr_array_free(pd->stripped, TRUE);
+    }
+    if (pd->column_spans != NULL) {
+      g_array_free(pd->column_spans, TRUE);
+    }
+    if (pd->column_regex != NULL) {
+      g_regex_unref(pd->column_regex);
+    }
+    helper_string_arena_free(pd->arena);
+    if (pd->map != NULL) {
+      munmap(pd->map, pd->map_len);
+    }
+    helper_haystack_cache_free(pd->haystack);
+    helper_column_store_free(pd->column_store);
+    helper_trigram_index_free(pd->trigram_index);
     g_free(pd->urgent_list);
     g_free(pd->active_list);
     g_free(pd->selected_list);
@@ -499,6 +1245,58 @@ static void dmenu_mode_free(Mode *sw) {
   }
 }
 
+/**
+ * @param sw The dmenu mode.
+ * @param columns The columns to fill.
+ *
+ * Export entry (stripped from markup) and meta as columns. Rows are only
+ * added to the store, so rows read since the previous call are appended.
+ *
+ * @returns TRUE if columns is filled.
+ */
+static gboolean dmenu_get_columns(const Mode *sw, ModeColumns *columns) {
+  DmenuModePrivateData *pd = (DmenuModePrivateData *)mode_get_private_data(sw);
+  if (pd->column_store == NULL) {
+    pd->column_store = helper_column_store_new(DMENU_NUM_FIELDS + 1);
+  }
+  for (unsigned int i = helper_column_store_get_num_rows(pd->column_store);
+       !pd->no_columns && i < pd->cmd_list_length; i++) {
+    const DmenuScriptEntry *extras = dmenu_get_extras(pd, i);
+    gsize text_len = 0;
+    const char *text = dmenu_get_text(pd, i, &text_len);
+    // Permanent rows always match, rows with broken markup never.
+    if ((extras != NULL && extras->permanent == TRUE) || text == NULL) {
+      pd->no_columns = TRUE;
+      break;
+    }
+    unsigned int row = helper_column_store_add_row(pd->column_store);
+    helper_column_store_set(pd->column_store, row, DMENU_FIELD_ENTRY, text,
+                            text_len);
+    helper_column_store_set(pd->column_store, row, DMENU_FIELD_META,
+                            extras ? extras->meta : NULL, -1);
+    gsize display_len = 0;
+    const char *display = dmenu_get_display(pd, i, &display_len);
+    helper_column_store_set(pd->column_store, row, DMENU_NUM_FIELDS, display,
+                            display_len);
+  }
+  if (pd->no_columns) {
+    return FALSE;
+  }
+  const ModeColumn *store_columns =
+      helper_column_store_get_columns(pd->column_store);
+  columns->num_rows = helper_column_store_get_num_rows(pd->column_store);
+  columns->num_columns = DMENU_NUM_FIELDS;
+  columns->columns = store_columns;
+  // With -display-columns the completion is formatted per row.
+  columns->completion = (ModeColumn){NULL, NULL};
+  if (pd->columns == NULL) {
+    columns->completion = store_columns[DMENU_NUM_FIELDS];
+  }
+  // The index holds the raw text, it does not match the stripped markup.
+  columns->index = pd->do_markup ? NULL : pd->trigram_index;
+  return TRUE;
+}
+
 #include "mode-private.h"
 /** dmenu Mode object. */
 Mode dmenu_mode = {.name = "dmenu",
@@ -513,6 +1311,8 @@ Mode dmenu_mode = {.name = "dmenu",
                    ._get_completion = dmenu_get_completion_data,
                    ._preprocess_input = NULL,
                    ._get_message = dmenu_get_message,
+                   ._get_columns = dmenu_get_columns,
+                   ._peek_completion = dmenu_peek_completion,
                    .private_data = NULL,
                    .free = NULL,
                    .display_name = "dmenu",
@@ -526,6 +1326,21 @@ static int dmenu_mode_init(Mode *sw) {
   DmenuModePrivateData *pd = (DmenuModePrivateData *)mode_get_private_data(sw);
 
   pd->async = TRUE;
+  pd->arena = helper_string_arena_new();
+  // The markup is stripped from the rows as they are read.
+  if (find_arg("-markup-rows") >= 0) {
+    pd->do_markup = TRUE;
+  }
+  if (config.normalize_match) {
+    pd->haystack = helper_haystack_cache_new(DMENU_NUM_FIELDS);
+  }
+  // The index is only queried on the (not normalized) raw text.
+  unsigned int trigram_index_size = 0;
+  find_arg_uint("-trigram-index", &trigram_index_size);
+  if (trigram_index_size > 0 && !config.normalize_match && !pd->do_markup) {
+    pd->trigram_index =
+        helper_trigram_index_new((gsize)trigram_index_size * 1024 * 1024);
+  }
   pd->multi_select = FALSE;
 
   // For now these only work in sync mode.
@@ -602,7 +1417,12 @@ static int dmenu_mode_init(Mode *sw) {
   if (find_arg("-i") >= 0) {
     config.case_sensitive = FALSE;
   }
-  if (pd->async) {
+  str = NULL;
+  find_arg_str("-input", &str);
+  // -dump streams the input itself, see dmenu_dump().
+  if (str != NULL && find_arg("-dump") < 0 && dmenu_map_input(pd, str)) {
+    // All rows are available at once.
+  } else if (pd->async) {
     pd->fd = STDIN_FILENO;
     if (find_arg_str("-input", &str)) {
       char *estr = rofi_expand_path(str);
@@ -650,13 +1470,28 @@ static int dmenu_mode_init(Mode *sw) {
       g_free(estr);
     }
 
-    read_input_sync(pd, -1);
+    // -dump streams the input itself, see dmenu_dump().
+    if (find_arg("-dump") < 0) {
+      read_input_sync(pd, -1);
+    }
   }
   gchar *columns = NULL;
   if (find_arg_str("-display-columns", &columns)) {
     pd->columns = g_strsplit(columns, ",", 0);
     pd->column_separator = "\t";
     find_arg_str("-display-column-separator", &pd->column_separator);
+    pd->num_columns = g_strv_length(pd->columns);
+    GError *error = NULL;
+    pd->column_regex =
+        g_regex_new(pd->column_separator, G_REGEX_CASELESS, 0, &error);
+    if (error != NULL) {
+      g_warning("Invalid column separator '%s': %s", pd->column_separator,
+                error->message);
+      g_error_free(error);
+    }
+    pd->column_spans = g_array_new(FALSE, FALSE, sizeof(DmenuColumnSpan));
+    // Rows read so far, rows read async are split as they come in.
+    dmenu_split_columns(pd);
   }
   return TRUE;
 }
@@ -666,19 +1501,15 @@ static int dmenu_token_match(const Mode *sw, rofi_int_matcher **tokens,
   DmenuModePrivateData *rmpd =
       (DmenuModePrivateData *)mode_get_private_data(sw);
 
-  /** Strip out the markup when matching. */
-  char *esc = NULL;
-  if (rmpd->cmd_list[index].permanent == TRUE) {
+  const DmenuScriptEntry *extras = dmenu_get_extras(rmpd, index);
+  if (extras != NULL && extras->permanent == TRUE) {
     // Always match
     return 1;
   }
 
-  if (rmpd->do_markup) {
-    pango_parse_markup(rmpd->cmd_list[index].entry, -1, 0, NULL, &esc, NULL,
-                       NULL);
-  } else {
-    esc = rmpd->cmd_list[index].entry;
-  }
+  /** Match the entry stripped from markup. */
+  gsize len = 0;
+  const char *esc = dmenu_get_text(rmpd, index, &len);
   if (esc) {
     //        int retv = helper_token_match ( tokens, esc );
     int match = 1;
@@ -686,9 +1517,12 @@ static int dmenu_token_match(const Mode *sw, rofi_int_matcher **tokens,
       for (int j = 0; match && tokens[j] != NULL; j++) {
         rofi_int_matcher *ftokens[2] = {tokens[j], NULL};
         int test = 0;
-        test = helper_token_match(ftokens, esc);
-        if (test == tokens[j]->invert && rmpd->cmd_list[index].meta) {
-          test = helper_token_match(ftokens, rmpd->cmd_list[index].meta);
+        test = helper_token_match_cached(ftokens, rmpd->haystack, index,
+                                         DMENU_FIELD_ENTRY, esc, len);
+        if (test == tokens[j]->invert && extras != NULL && extras->meta) {
+          test = helper_token_match_cached(ftokens, rmpd->haystack, index,
+                                           DMENU_FIELD_META, extras->meta,
+                                           -1);
         }
 
         if (test == 0) {
@@ -696,9 +1530,6 @@ static int dmenu_token_match(const Mode *sw, rofi_int_matcher **tokens,
         }
       }
     }
-    if (rmpd->do_markup) {
-      g_free(esc);
-    }
     return match;
   }
   return FALSE;
@@ -716,8 +1547,8 @@ static cairo_surface_t *dmenu_get_icon(const Mode *sw,
   DmenuModePrivateData *pd = (DmenuModePrivateData *)mode_get_private_data(sw);
 
   g_return_val_if_fail(pd->cmd_list != NULL, NULL);
-  DmenuScriptEntry *dr = &(pd->cmd_list[selected_line]);
-  if (dr->icon_name == NULL) {
+  DmenuScriptEntry *dr = dmenu_get_extras(pd, selected_line);
+  if (dr == NULL || dr->icon_name == NULL) {
     return NULL;
   }
   uint32_t uid = dr->icon_fetch_uid =
@@ -743,7 +1574,7 @@ static void dmenu_finish(DmenuModePrivateData *pd, RofiViewState *state,
     g_async_queue_lock(pd->async_queue);
     Block *block = NULL;
     while ((block = g_async_queue_try_pop_unlocked(pd->async_queue)) != NULL) {
-      g_free(block);
+      block_free(block);
     }
     g_async_queue_unlock(pd->async_queue);
     g_async_queue_unref(pd->async_queue);
@@ -769,24 +1600,31 @@ static void dmenu_finish(DmenuModePrivateData *pd, RofiViewState *state,
 }
 
 static void dmenu_print_results(DmenuModePrivateData *pd, const char *input) {
-  DmenuScriptEntry *cmd_list = pd->cmd_list;
+  DmenuRow *cmd_list = pd->cmd_list;
   int seen = FALSE;
   if (pd->selected_list != NULL) {
     for (unsigned int st = 0; st < pd->cmd_list_length; st++) {
       if (bitget(pd->selected_list, st)) {
         seen = TRUE;
-        rofi_output_formatted_line(pd->format, cmd_list[st].entry, st, input);
+        char *entry = g_strndup(cmd_list[st].entry, cmd_list[st].length);
+        rofi_output_formatted_line(pd->format, entry, st, input);
+        g_free(entry);
       }
     }
   }
   if (!seen) {
-    const char *cmd = input;
+    char *cmd = g_strdup(input);
     if (pd->selected_line != UINT32_MAX) {
-      cmd = cmd_list[pd->selected_line].entry;
+      g_free(cmd);
+      cmd = pd->selected_line < pd->cmd_list_length
+                ? g_strndup(cmd_list[pd->selected_line].entry,
+                            cmd_list[pd->selected_line].length)
+                : NULL;
     }
     if (cmd) {
       rofi_output_formatted_line(pd->format, cmd, pd->selected_line, input);
     }
+    g_free(cmd);
   }
 }
 
@@ -796,7 +1634,6 @@ static void dmenu_finalize(RofiViewState *state) {
       (DmenuModePrivateData *)rofi_view_get_mode(state)->private_data;
 
   unsigned int cmd_list_length = pd->cmd_list_length;
-  DmenuScriptEntry *cmd_list = pd->cmd_list;
 
   char *input = g_strdup(rofi_view_get_user_input(state));
   pd->selected_line = rofi_view_get_selected_line(state);
@@ -836,8 +1673,10 @@ static void dmenu_finalize(RofiViewState *state) {
           rofi_view_set_overlay(state, NULL);
         }
       } else if ((mretv & (MENU_OK | MENU_CUSTOM_COMMAND)) &&
-                 cmd_list[pd->selected_line].entry != NULL) {
-        if (cmd_list[pd->selected_line].nonselectable == TRUE) {
+                 pd->selected_line < cmd_list_length) {
+        const DmenuScriptEntry *extras =
+            dmenu_get_extras(pd, pd->selected_line);
+        if (extras != NULL && extras->nonselectable == TRUE) {
           g_free(input);
           return;
         }
@@ -864,10 +1703,10 @@ static void dmenu_finalize(RofiViewState *state) {
   // We normally do not want to restart the loop.
   restart = FALSE;
   // Normal mode
-  if ((mretv & MENU_OK) && pd->selected_line != UINT32_MAX &&
-      cmd_list[pd->selected_line].entry != NULL) {
+  if ((mretv & MENU_OK) && pd->selected_line < cmd_list_length) {
     // Check if entry is non-selectable.
-    if (cmd_list[pd->selected_line].nonselectable == TRUE) {
+    const DmenuScriptEntry *extras = dmenu_get_extras(pd, pd->selected_line);
+    if (extras != NULL && extras->nonselectable == TRUE) {
       g_free(input);
       return;
     }
@@ -917,6 +1756,292 @@ static void dmenu_finalize(RofiViewState *state) {
   }
 }
 
+/** Bytes of input per chunk of -dump work. */
+#define DUMP_CHUNK_SIZE (1024 * 1024)
+
+/** A matching row found by -dump. */
+typedef struct {
+  /** Sort distance, only set with -top. */
+  int distance;
+  /** Row in the input, relative to the chunk until it is collected. */
+  unsigned int row;
+  /** The entry. */
+  const char *entry;
+} DmenuDumpMatch;
+
+/** State of -dump shared by all chunks. */
+typedef struct {
+  /** Tokens to match, NULL matches all rows. */
+  rofi_int_matcher **tokens;
+  /** The filter, for fzf sorting. */
+  const char *pattern;
+  /** Length of pattern in characters. */
+  glong plen;
+  /** Pattern prepared for levenshtein sorting. */
+  RofiLevenshteinNeedle *lev_needle;
+  /** Number of best matches to print, 0 prints all in input order. */
+  unsigned int top;
+  /** Row separator. */
+  char separator;
+  /** Lock for the done flag of the chunks. */
+  GMutex mutex;
+  /** Signalled when a chunk is done. */
+  GCond cond;
+} DmenuDump;
+
+/** A chunk of input, filtered by a worker. */
+typedef struct {
+  /** Generic thread state. */
+  thread_state st;
+  /** The shared state. */
+  DmenuDump *dump;
+  /** The rows, each ends with the separator except the last at the end of
+   * the input. Has room for one more byte. */
+  char *data;
+  /** Length of data in bytes. */
+  gsize len;
+  /** Number of rows in data. */
+  unsigned int num_rows;
+  /** Array of #DmenuDumpMatch. */
+  GArray *matches;
+  /** Entries converted to valid UTF-8. */
+  GPtrArray *strings;
+  /** Set when the worker is done, protected by the mutex of dump. */
+  gboolean done;
+} DmenuDumpChunk;
+
+static gint dmenu_dump_match_cmp(gconstpointer a, gconstpointer b) {
+  const DmenuDumpMatch *ma = (const DmenuDumpMatch *)a;
+  const DmenuDumpMatch *mb = (const DmenuDumpMatch *)b;
+  if (ma->distance != mb->distance) {
+    return (ma->distance > mb->distance) - (ma->distance < mb->distance);
+  }
+  return (ma->row > mb->row) - (ma->row < mb->row);
+}
+
+/**
+ * @param matches Array of #DmenuDumpMatch.
+ * @param top Number of matches to keep.
+ * @param owned If the entries are owned by the array.
+ *
+ * Sort the matches on distance and drop all but the best top.
+ */
+static void dmenu_dump_keep_best(GArray *matches, unsigned int top,
+                                 gboolean owned) {
+  g_array_sort(matches, dmenu_dump_match_cmp);
+  for (guint i = top; owned && i < matches->len; i++) {
+    g_free((char *)g_array_index(matches, DmenuDumpMatch, i).entry);
+  }
+  if (matches->len > top) {
+    g_array_set_size(matches, top);
+  }
+}
+
+/**
+ * @param ts The chunk.
+ * @param user_data Unused.
+ *
+ * Split the chunk in rows, filter and (with -top) score them.
+ */
+static void dmenu_dump_chunk_filter(thread_state *ts,
+                                    G_GNUC_UNUSED gpointer user_data) {
+  DmenuDumpChunk *chunk = (DmenuDumpChunk *)ts;
+  DmenuDump *dump = chunk->dump;
+  char *iter = chunk->data;
+  char *end = chunk->data + chunk->len;
+  while (iter < end) {
+    char *line_end = memchr(iter, dump->separator, end - iter);
+    if (line_end == NULL) {
+      line_end = end;
+    }
+    // Cut the row, extra fields after a NUL are ignored.
+    *line_end = '\0';
+    const char *entry = iter;
+    if (!g_utf8_validate(iter, -1, NULL)) {
+      char *utfstr = rofi_force_utf8(iter, strlen(iter));
+      g_ptr_array_add(chunk->strings, utfstr);
+      entry = utfstr;
+    }
+    if (dump->tokens == NULL || helper_token_match(dump->tokens, entry)) {
+      DmenuDumpMatch match = {.distance = 0,
+                              .row = chunk->num_rows,
+                              .entry = entry};
+      if (dump->top > 0 && dump->pattern != NULL) {
+        if (config.sorting_method_enum == SORT_FZF) {
+          match.distance = rofi_scorer_fuzzy_evaluate(
+              dump->pattern, dump->plen, entry, g_utf8_strlen(entry, -1));
+        } else {
+          match.distance = levenshtein_needle_distance(dump->lev_needle,
+                                                       entry, -1, UINT_MAX);
+        }
+      }
+      g_array_append_val(chunk->matches, match);
+    }
+    chunk->num_rows++;
+    iter = line_end + 1;
+  }
+  if (dump->top > 0) {
+    dmenu_dump_keep_best(chunk->matches, dump->top, FALSE);
+  }
+  g_mutex_lock(&(dump->mutex));
+  chunk->done = TRUE;
+  g_cond_broadcast(&(dump->cond));
+  g_mutex_unlock(&(dump->mutex));
+}
+
+static void dmenu_dump_chunk_free(DmenuDumpChunk *chunk) {
+  g_free(chunk->data);
+  g_array_free(chunk->matches, TRUE);
+  g_ptr_array_free(chunk->strings, TRUE);
+  g_free(chunk);
+}
+
+/**
+ * @param pd The dmenu private data.
+ * @param dump The shared state.
+ * @param chunk The oldest chunk, freed.
+ * @param row_base Row in the input of the first row of the chunk, advanced
+ * past the chunk.
+ * @param best The best matches so far with -top.
+ *
+ * Wait for the chunk and print its matches, or with -top merge them with
+ * the best matches so far.
+ */
+static void dmenu_dump_chunk_collect(DmenuModePrivateData *pd,
+                                     DmenuDump *dump, DmenuDumpChunk *chunk,
+                                     unsigned int *row_base, GArray *best) {
+  g_mutex_lock(&(dump->mutex));
+  while (!chunk->done) {
+    g_cond_wait(&(dump->cond), &(dump->mutex));
+  }
+  g_mutex_unlock(&(dump->mutex));
+  for (guint i = 0; i < chunk->matches->len; i++) {
+    DmenuDumpMatch match = g_array_index(chunk->matches, DmenuDumpMatch, i);
+    match.row += *row_base;
+    if (dump->top == 0) {
+      rofi_output_formatted_line_buffered(pd->format, match.entry, match.row,
+                                          config.filter);
+    } else {
+      match.entry = g_strdup(match.entry);
+      g_array_append_val(best, match);
+    }
+  }
+  if (dump->top > 0 && best->len >= 2 * dump->top) {
+    dmenu_dump_keep_best(best, dump->top, TRUE);
+  }
+  *row_base += chunk->num_rows;
+  dmenu_dump_chunk_free(chunk);
+}
+
+/**
+ * @param pd The dmenu private data.
+ *
+ * Filter the input for -dump without a UI. The input is read in chunks that
+ * are split in rows, filtered and scored by the thread pool, while this
+ * thread reads ahead and prints the results in input order as they come in.
+ * With -top only the best matches are kept and printed, best first.
+ */
+static void dmenu_dump(DmenuModePrivateData *pd) {
+  DmenuDump dump = {.separator = pd->separator};
+  if (config.filter != NULL && config.filter[0] != '\0') {
+    dump.tokens = helper_tokenize(config.filter, config.case_sensitive);
+    dump.pattern = config.filter;
+    dump.plen = g_utf8_strlen(config.filter, -1);
+  }
+  find_arg_uint("-top", &(dump.top));
+  if (dump.top > 0 && dump.pattern != NULL &&
+      config.sorting_method_enum != SORT_FZF) {
+    dump.lev_needle = levenshtein_needle_new(dump.pattern, dump.plen);
+  }
+  g_mutex_init(&(dump.mutex));
+  g_cond_init(&(dump.cond));
+
+  GArray *best = g_array_new(FALSE, FALSE, sizeof(DmenuDumpMatch));
+  GQueue pending = G_QUEUE_INIT;
+  // Bound the read ahead, so memory use does not depend on the input size.
+  unsigned int max_pending = 2 * MAX(1, config.threads);
+  unsigned int row_base = 0;
+  guint64 bytes = 0;
+  GTimer *timer = g_timer_new();
+  // The start of a row that did not fit in the previous chunk.
+  char *rest = NULL;
+  gsize rest_len = 0;
+  gboolean eof = FALSE;
+  while (!eof) {
+    gsize size = MAX(DUMP_CHUNK_SIZE, 2 * rest_len);
+    // Room to terminate a last row without separator.
+    char *data = g_malloc(size + 1);
+    if (rest_len > 0) {
+      memcpy(data, rest, rest_len);
+    }
+    g_free(rest);
+    rest = NULL;
+    gsize len = rest_len + fread(data + rest_len, 1, size - rest_len,
+                                 pd->fd_file);
+    rest_len = 0;
+    eof = len < size;
+    bytes += len;
+    if (!eof) {
+      // Keep the last, incomplete, row for the next chunk.
+      char *last = memrchr(data, pd->separator, len);
+      gsize cut = (last != NULL) ? (gsize)(last - data) + 1 : 0;
+      rest_len = len - cut;
+      rest = g_memdup2(data + cut, rest_len);
+      len = cut;
+    }
+    if (len == 0) {
+      g_free(data);
+      continue;
+    }
+    DmenuDumpChunk *chunk = g_malloc0(sizeof(DmenuDumpChunk));
+    chunk->st.callback = dmenu_dump_chunk_filter;
+    chunk->st.priority = G_PRIORITY_LOW;
+    chunk->dump = &dump;
+    chunk->data = data;
+    chunk->len = len;
+    chunk->matches = g_array_new(FALSE, FALSE, sizeof(DmenuDumpMatch));
+    chunk->strings = g_ptr_array_new_with_free_func(g_free);
+    g_queue_push_tail(&pending, chunk);
+    if (config.threads > 1) {
+      g_thread_pool_push(tpool, chunk, NULL);
+    } else {
+      dmenu_dump_chunk_filter((thread_state *)chunk, NULL);
+    }
+    while (pending.length >= max_pending) {
+      dmenu_dump_chunk_collect(pd, &dump, g_queue_pop_head(&pending),
+                               &row_base, best);
+    }
+  }
+  while (!g_queue_is_empty(&pending)) {
+    dmenu_dump_chunk_collect(pd, &dump, g_queue_pop_head(&pending), &row_base,
+                             best);
+  }
+  if (dump.top > 0) {
+    dmenu_dump_keep_best(best, dump.top, TRUE);
+    for (guint i = 0; i < best->len; i++) {
+      DmenuDumpMatch *match = &g_array_index(best, DmenuDumpMatch, i);
+      rofi_output_formatted_line_buffered(pd->format, match->entry,
+                                          match->row, config.filter);
+      g_free((char *)match->entry);
+    }
+  }
+  fflush(stdout);
+  double elapsed = g_timer_elapsed(timer, NULL);
+  g_debug("Dump filtered %u rows (%.1f MiB) in %.3f s: %.0f rows/s, %.1f "
+          "MiB/s.",
+          row_base, bytes / (1024.0 * 1024.0), elapsed,
+          row_base / MAX(elapsed, 1e-6),
+          bytes / (1024.0 * 1024.0) / MAX(elapsed, 1e-6));
+  g_timer_destroy(timer);
+  g_array_free(best, TRUE);
+  levenshtein_needle_free(dump.lev_needle);
+  if (dump.tokens) {
+    helper_tokenize_free(dump.tokens);
+  }
+  g_mutex_clear(&(dump.mutex));
+  g_cond_clear(&(dump.cond));
+}
+
 int dmenu_mode_dialog(void) {
   mode_init(&dmenu_mode);
   MenuFlags menu_flags = MENU_NORMAL;
@@ -924,7 +2049,7 @@ int dmenu_mode_dialog(void) {
 
   char *input = NULL;
   unsigned int cmd_list_length = pd->cmd_list_length;
-  DmenuScriptEntry *cmd_list = pd->cmd_list;
+  DmenuRow *cmd_list = pd->cmd_list;
 
   pd->only_selected = FALSE;
   pd->ballot_selected = "☑ ";
@@ -932,8 +2057,12 @@ int dmenu_mode_dialog(void) {
   find_arg_str("-ballot-selected-str", &(pd->ballot_selected));
   find_arg_str("-ballot-unselected-str", &(pd->ballot_unselected));
 
-  if (find_arg("-markup-rows") >= 0) {
-    pd->do_markup = TRUE;
+  if (find_arg("-dump") >= 0) {
+    if (pd->fd_file != NULL) {
+      dmenu_dump(pd);
+    }
+    dmenu_mode_free(&dmenu_mode);
+    return TRUE;
   }
   if (find_arg("-only-match") >= 0 || find_arg("-no-custom") >= 0) {
     pd->only_selected = TRUE;
@@ -942,7 +2071,9 @@ int dmenu_mode_dialog(void) {
     }
   }
   if (config.auto_select && cmd_list_length == 1) {
-    rofi_output_formatted_line(pd->format, cmd_list[0].entry, 0, config.filter);
+    char *entry = g_strndup(cmd_list[0].entry, cmd_list[0].length);
+    rofi_output_formatted_line(pd->format, entry, 0, config.filter);
+    g_free(entry);
     return TRUE;
   }
   if (find_arg("-password") >= 0) {
@@ -957,28 +2088,14 @@ int dmenu_mode_dialog(void) {
     rofi_int_matcher **tokens = helper_tokenize(select, config.case_sensitive);
     unsigned int i = 0;
     for (i = 0; i < cmd_list_length; i++) {
-      if (helper_token_match(tokens, cmd_list[i].entry)) {
+      if (helper_token_match_len(tokens, cmd_list[i].entry,
+                                 cmd_list[i].length)) {
         pd->selected_line = i;
         break;
       }
     }
     helper_tokenize_free(tokens);
   }
-  if (find_arg("-dump") >= 0) {
-    rofi_int_matcher **tokens = helper_tokenize(
-        config.filter ? config.filter : "", config.case_sensitive);
-    unsigned int i = 0;
-    for (i = 0; i < cmd_list_length; i++) {
-      if (tokens == NULL || helper_token_match(tokens, cmd_list[i].entry)) {
-        rofi_output_formatted_line(pd->format, cmd_list[i].entry, i,
-                                   config.filter);
-      }
-    }
-    helper_tokenize_free(tokens);
-    dmenu_mode_free(&dmenu_mode);
-    g_free(input);
-    return TRUE;
-  }
   find_arg_str("-p", &(dmenu_mode.display_name));
   RofiViewState *state =
       rofi_view_create(&dmenu_mode, input, menu_flags, dmenu_finalize);
@@ -1044,6 +2161,9 @@ void print_dmenu_options(void) {
   print_help_msg("-input", "[filename]",
                  "Read input from file instead from standard input.", NULL,
                  is_term);
+  print_help_msg("-top", "[integer]",
+                 "With -dump, only print the best matches, best first", NULL,
+                 is_term);
   print_help_msg("-sync", "",
                  "Force dmenu to first read all input data, then show dialog.",
                  NULL, is_term);
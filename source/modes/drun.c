@@ -223,6 +223,11 @@ struct _DRunModePrivateData {
   char *old_completer_input;
   uint32_t selected_line;
   char *old_input;
+
+  /** Name and the enabled matching fields, see drun_get_columns. */
+  RofiColumnStore *column_store;
+  /** Number of matching columns in column_store. */
+  unsigned int num_match_columns;
 };
 
 struct RegexEvalArg {
@@ -1024,6 +1029,7 @@ static gboolean drun_read_cache(DRunModePrivateData *pd,
 static void get_apps(DRunModePrivateData *pd) {
   char *cache_file = g_build_filename(cache_dir, DRUN_DESKTOP_CACHE_FILE, NULL);
   TICK_N("Get Desktop apps (start)");
+  TRACE_BEGIN("Get Desktop apps");
   if (drun_read_cache(pd, cache_file)) {
     ThemeWidget *wid = rofi_config_find_widget(drun_mode.name, NULL, TRUE);
 
@@ -1080,6 +1086,7 @@ static void get_apps(DRunModePrivateData *pd) {
     write_cache(pd, cache_file);
   }
   g_free(cache_file);
+  TRACE_END("Get Desktop apps");
 }
 
 static void drun_mode_parse_entry_fields(void) {
@@ -1241,6 +1248,8 @@ static ModeMode drun_mode_result(Mode *sw, int mretv, char **input,
               sizeof(DRunModeEntry) *
                   (rmpd->cmd_list_length - selected_line - 1));
       rmpd->cmd_list_length--;
+      helper_column_store_free(rmpd->column_store);
+      rmpd->column_store = NULL;
     }
     retv = RELOAD_DIALOG;
   } else if (mretv & MENU_CUSTOM_COMMAND) {
@@ -1289,6 +1298,7 @@ static void drun_mode_destroy(Mode *sw) {
     }
     g_hash_table_destroy(rmpd->disabled_entries);
     g_free(rmpd->entry_list);
+    helper_column_store_free(rmpd->column_store);
 
     g_free(rmpd->old_completer_input);
     g_free(rmpd->old_input);
@@ -1406,6 +1416,15 @@ static char *drun_get_completion(const Mode *sw, unsigned int index) {
   return g_strdup_printf("%s", dr->name);
 }
 
+static const char *drun_peek_completion(const Mode *sw, unsigned int index) {
+  const DRunModePrivateData *pd =
+      (const DRunModePrivateData *)mode_get_private_data(sw);
+  if (pd->file_complete) {
+    return mode_peek_completion(pd->completer, index);
+  }
+  return pd->entry_list[index].name;
+}
+
 static int drun_token_match(const Mode *data, rofi_int_matcher **tokens,
                             unsigned int index) {
   DRunModePrivateData *rmpd =
@@ -1416,7 +1435,8 @@ static int drun_token_match(const Mode *data, rofi_int_matcher **tokens,
   int match = 1;
   if (tokens) {
     for (int j = 0; match && tokens[j] != NULL; j++) {
-      int test = 0;
+      // An inverted token matches until a field contains it.
+      int test = tokens[j]->invert;
       rofi_int_matcher *ftokens[2] = {tokens[j], NULL};
       // Match name
       if (matching_entry_fields[DRUN_MATCH_FIELD_NAME].enabled_match) {
@@ -1480,6 +1500,112 @@ static int drun_token_match(const Mode *data, rofi_int_matcher **tokens,
   return match;
 }
 
+/**
+ * @param store The column store.
+ * @param row The row to set.
+ * @param column The first column to set, moved past the list.
+ * @param list The list to store (or NULL).
+ * @param length The number of columns reserved for the list.
+ *
+ * Store each item of list in its own column, so each is matched on its own.
+ */
+static void drun_column_store_set_list(RofiColumnStore *store,
+                                       unsigned int row, unsigned int *column,
+                                       gchar **list, unsigned int length) {
+  for (unsigned int i = 0; i < length; i++) {
+    const char *value = NULL;
+    if (list != NULL && *list != NULL) {
+      value = *list;
+      list++;
+    }
+    helper_column_store_set(store, row, (*column)++, value, -1);
+  }
+}
+
+/**
+ * @param pd The drun private data.
+ *
+ * Fill a column store with the name (for sorting) and the enabled matching
+ * fields of all entries.
+ */
+static void drun_column_store_build(DRunModePrivateData *pd) {
+  unsigned int num_categories = 0;
+  unsigned int num_keywords = 0;
+  for (unsigned int i = 0; i < pd->cmd_list_length; i++) {
+    DRunModeEntry *e = &(pd->entry_list[i]);
+    if (e->categories) {
+      num_categories = MAX(num_categories, g_strv_length(e->categories));
+    }
+    if (e->keywords) {
+      num_keywords = MAX(num_keywords, g_strv_length(e->keywords));
+    }
+  }
+  if (!matching_entry_fields[DRUN_MATCH_FIELD_CATEGORIES].enabled_match) {
+    num_categories = 0;
+  }
+  if (!matching_entry_fields[DRUN_MATCH_FIELD_KEYWORDS].enabled_match) {
+    num_keywords = 0;
+  }
+  pd->num_match_columns = num_categories + num_keywords;
+  for (unsigned int f = 0; f < DRUN_MATCH_NUM_FIELDS; f++) {
+    if (f != DRUN_MATCH_FIELD_CATEGORIES && f != DRUN_MATCH_FIELD_KEYWORDS &&
+        matching_entry_fields[f].enabled_match) {
+      pd->num_match_columns++;
+    }
+  }
+
+  pd->column_store = helper_column_store_new(pd->num_match_columns + 1);
+  for (unsigned int i = 0; i < pd->cmd_list_length; i++) {
+    DRunModeEntry *e = &(pd->entry_list[i]);
+    unsigned int row = helper_column_store_add_row(pd->column_store);
+    unsigned int column = 0;
+    helper_column_store_set(pd->column_store, row, column++, e->name, -1);
+    if (matching_entry_fields[DRUN_MATCH_FIELD_NAME].enabled_match) {
+      helper_column_store_set(pd->column_store, row, column++, e->name, -1);
+    }
+    if (matching_entry_fields[DRUN_MATCH_FIELD_GENERIC].enabled_match) {
+      helper_column_store_set(pd->column_store, row, column++,
+                              e->generic_name, -1);
+    }
+    if (matching_entry_fields[DRUN_MATCH_FIELD_EXEC].enabled_match) {
+      helper_column_store_set(pd->column_store, row, column++, e->exec, -1);
+    }
+    drun_column_store_set_list(pd->column_store, row, &column, e->categories,
+                               num_categories);
+    drun_column_store_set_list(pd->column_store, row, &column, e->keywords,
+                               num_keywords);
+    if (matching_entry_fields[DRUN_MATCH_FIELD_URL].enabled_match) {
+      helper_column_store_set(pd->column_store, row, column++, e->url, -1);
+    }
+    if (matching_entry_fields[DRUN_MATCH_FIELD_COMMENT].enabled_match) {
+      helper_column_store_set(pd->column_store, row, column++, e->comment, -1);
+    }
+  }
+}
+
+/**
+ * @param sw The drun mode.
+ * @param columns The columns to fill.
+ *
+ * @returns TRUE if columns is filled, FALSE while completing a file.
+ */
+static gboolean drun_get_columns(const Mode *sw, ModeColumns *columns) {
+  DRunModePrivateData *pd = (DRunModePrivateData *)mode_get_private_data(sw);
+  if (pd->file_complete) {
+    return FALSE;
+  }
+  if (pd->column_store == NULL) {
+    drun_column_store_build(pd);
+  }
+  const ModeColumn *store_columns =
+      helper_column_store_get_columns(pd->column_store);
+  columns->num_rows = helper_column_store_get_num_rows(pd->column_store);
+  columns->num_columns = pd->num_match_columns;
+  columns->columns = &(store_columns[1]);
+  columns->completion = store_columns[0];
+  return TRUE;
+}
+
 static unsigned int drun_mode_get_num_entries(const Mode *sw) {
   const DRunModePrivateData *pd =
       (const DRunModePrivateData *)mode_get_private_data(sw);
@@ -1517,6 +1643,8 @@ Mode drun_mode = {.name = "drun",
                   ._token_match = drun_token_match,
                   ._get_message = drun_get_message,
                   ._get_completion = drun_get_completion,
+                  ._get_columns = drun_get_columns,
+                  ._peek_completion = drun_peek_completion,
                   ._get_display_value = _get_display_value,
                   ._get_icon = _get_icon,
                   ._preprocess_input = NULL,
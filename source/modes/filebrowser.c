@@ -637,6 +637,16 @@ static char *_get_completion(const Mode *sw, unsigned int index) {
   return d;
 }
 
+static const char *_peek_completion(const Mode *sw, unsigned int index) {
+  FileBrowserModePrivateData *pd =
+      (FileBrowserModePrivateData *)mode_get_private_data(sw);
+  // The path as is, scoring an escaped path against the input is pointless.
+  if (pd->array[index].path == NULL) {
+    return pd->array[index].name;
+  }
+  return pd->array[index].path;
+}
+
 Mode *create_new_file_browser(void) {
   Mode *sw = g_malloc0(sizeof(Mode));
 
@@ -715,6 +725,7 @@ Mode file_browser_mode = {.display_name = NULL,
                           ._get_icon = _get_icon,
                           ._get_message = _get_message,
                           ._get_completion = _get_completion,
+                          ._peek_completion = _peek_completion,
                           ._preprocess_input = NULL,
                           ._create = create_new_file_browser,
                           ._completer_result = file_browser_mode_completer,
@@ -333,6 +333,8 @@ static gboolean recursive_browser_async_read_proc(gint fd,
     if (command == 'r') {
       FBFile *block = NULL;
       gboolean changed = FALSE;
+      // The list is about to change, filtering should not read it.
+      rofi_view_filter_finish();
       // Empty out the AsyncQueue (that is thread safe) from all blocks pushed
       // into it.
       while ((block = g_async_queue_try_pop(pd->async_queue)) != NULL) {
@@ -527,6 +529,16 @@ static char *_get_completion(const Mode *sw, unsigned int index) {
   return d;
 }
 
+static const char *_peek_completion(const Mode *sw, unsigned int index) {
+  FileBrowserModePrivateData *pd =
+      (FileBrowserModePrivateData *)mode_get_private_data(sw);
+  // The path as is, scoring an escaped path against the input is pointless.
+  if (pd->array[index].path == NULL) {
+    return pd->array[index].name;
+  }
+  return pd->array[index].path;
+}
+
 Mode *create_new_recursive_browser(void) {
   Mode *sw = g_malloc0(sizeof(Mode));
 
@@ -574,6 +586,7 @@ Mode recursive_browser_mode = {
     ._get_icon = _get_icon,
     ._get_message = _get_message,
     ._get_completion = _get_completion,
+    ._peek_completion = _peek_completion,
     ._preprocess_input = NULL,
     ._create = create_new_recursive_browser,
     ._completer_result = recursive_browser_mode_completer,
@@ -543,6 +543,15 @@ static char *_get_display_value(const Mode *sw, unsigned int selected_line,
   return get_entry ? g_strdup(rmpd->cmd_list[selected_line].entry) : NULL;
 }
 
+static const char *run_peek_completion(const Mode *sw, unsigned int index) {
+  const RunModePrivateData *rmpd = (const RunModePrivateData *)sw->private_data;
+  if (rmpd->file_complete) {
+    // Completion is the display value of the completer.
+    return NULL;
+  }
+  return rmpd->cmd_list[index].entry;
+}
+
 static int run_token_match(const Mode *sw, rofi_int_matcher **tokens,
                            unsigned int index) {
   const RunModePrivateData *rmpd = (const RunModePrivateData *)sw->private_data;
@@ -606,6 +615,7 @@ Mode run_mode = {.name = "run",
                  ._get_display_value = _get_display_value,
                  ._get_icon = _get_icon,
                  ._get_completion = NULL,
+                 ._peek_completion = run_peek_completion,
                  ._preprocess_input = NULL,
                  .private_data = NULL,
                  .free = NULL,
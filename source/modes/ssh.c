@@ -619,6 +619,18 @@ static char *_get_display_value(const Mode *sw, unsigned int selected_line,
   return get_entry ? g_strdup(rmpd->hosts_list[selected_line].hostname) : NULL;
 }
 
+/**
+ * @param sw Object handle to the SSH Mode object
+ * @param selected_line The line to get the completion for
+ *
+ * @returns the hostname of the line, owned by the mode.
+ */
+static const char *ssh_peek_completion(const Mode *sw,
+                                       unsigned int selected_line) {
+  SSHModePrivateData *rmpd = (SSHModePrivateData *)mode_get_private_data(sw);
+  return rmpd->hosts_list[selected_line].hostname;
+}
+
 /**
  * @param sw Object handle to the SSH Mode object
  * @param tokens The set of tokens to match against
@@ -643,6 +655,7 @@ Mode ssh_mode = {.name = "ssh",
                  ._token_match = ssh_token_match,
                  ._get_display_value = _get_display_value,
                  ._get_completion = NULL,
+                 ._peek_completion = ssh_peek_completion,
                  ._preprocess_input = NULL,
                  .private_data = NULL,
                  .free = NULL,
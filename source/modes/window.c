@@ -152,6 +152,8 @@ typedef struct {
   // Hide current active window
   gboolean hide_active_window;
   gboolean prefer_icon_theme;
+  // Display string of each window, used as completion.
+  char **completions;
 } WindowModePrivateData;
 
 winlist *cache_client = NULL;
@@ -400,6 +402,8 @@ static client *window_client(WindowModePrivateData *pd, xcb_window_t win) {
 guint window_reload_timeout = 0;
 static gboolean window_client_reload(G_GNUC_UNUSED void *data) {
   window_reload_timeout = 0;
+  // The list is about to change, filtering should not read it.
+  rofi_view_filter_finish();
   if (window_mode.private_data) {
     window_mode._destroy(&window_mode);
     window_mode._init(&window_mode);
@@ -696,6 +700,7 @@ static void _window_mode_load_data(Mode *sw, unsigned int cd) {
   }
   xcb_ewmh_get_windows_reply_wipe(&clients);
 }
+static void window_mode_build_completions(WindowModePrivateData *pd);
 static int window_mode_init(Mode *sw) {
   if (mode_get_private_data(sw) == NULL) {
 
@@ -714,6 +719,7 @@ static int window_mode_init(Mode *sw) {
     pd->window_regex = g_regex_new("{[-\\w]+(:-?[0-9]+)?}", 0, 0, NULL);
     mode_set_private_data(sw, (void *)pd);
     _window_mode_load_data(sw, FALSE);
+    window_mode_build_completions(pd);
     if (!window_matching_fields_parsed) {
       window_mode_parse_fields();
     }
@@ -733,6 +739,7 @@ static int window_mode_init_cd(Mode *sw) {
     pd->window_regex = g_regex_new("{[-\\w]+(:-?[0-9]+)?}", 0, 0, NULL);
     mode_set_private_data(sw, (void *)pd);
     _window_mode_load_data(sw, TRUE);
+    window_mode_build_completions(pd);
     if (!window_matching_fields_parsed) {
       window_mode_parse_fields();
     }
@@ -864,6 +871,11 @@ static void window_mode_destroy(Mode *sw) {
   WindowModePrivateData *rmpd =
       (WindowModePrivateData *)mode_get_private_data(sw);
   if (rmpd != NULL) {
+    // Holes for vanished windows, so not g_strfreev.
+    for (int i = 0; rmpd->completions && i < rmpd->ids->len; i++) {
+      g_free(rmpd->completions[i]);
+    }
+    g_free(rmpd->completions);
     winlist_free(rmpd->ids);
     x11_cache_free();
     g_free(rmpd->cache);
@@ -945,6 +957,31 @@ static char *_generate_display_string(const WindowModePrivateData *pd,
   return g_strchomp(res);
 }
 
+/**
+ * @param pd The window mode private data.
+ *
+ * Generate the display string of all windows once, so sorting does not have
+ * to generate them on every match. Vanished windows get no string.
+ */
+static void window_mode_build_completions(WindowModePrivateData *pd) {
+  if (pd->ids == NULL) {
+    return;
+  }
+  pd->completions = g_malloc0_n(MAX(1, pd->ids->len), sizeof(char *));
+  for (int i = 0; i < pd->ids->len; i++) {
+    const client *c = window_client(pd, pd->ids->array[i]);
+    if (c != NULL) {
+      pd->completions[i] = _generate_display_string(pd, c);
+    }
+  }
+}
+
+static const char *window_peek_completion(const Mode *sw,
+                                          unsigned int selected_line) {
+  const WindowModePrivateData *rmpd = mode_get_private_data(sw);
+  return rmpd->completions[selected_line];
+}
+
 static char *_get_display_value(const Mode *sw, unsigned int selected_line,
                                 int *state, G_GNUC_UNUSED GList **list,
                                 int get_entry) {
@@ -1142,6 +1179,7 @@ Mode window_mode = {.name = "window",
                     ._get_display_value = _get_display_value,
                     ._get_icon = _get_icon,
                     ._get_completion = NULL,
+                    ._peek_completion = window_peek_completion,
                     ._preprocess_input = NULL,
                     .private_data = NULL,
                     .free = NULL,
@@ -1156,6 +1194,7 @@ Mode window_mode_cd = {.name = "windowcd",
                        ._get_display_value = _get_display_value,
                        ._get_icon = _get_icon,
                        ._get_completion = NULL,
+                       ._peek_completion = window_peek_completion,
                        ._preprocess_input = NULL,
                        .private_data = NULL,
                        .free = NULL,
@@ -36,6 +36,7 @@
 #include "rofi-icon-fetcher.h"
 #include "rofi-types.h"
 #include "settings.h"
+#include "timings.h"
 #include <cairo.h>
 #include <pango/pangocairo.h>
 
@@ -525,8 +526,8 @@ static gchar* rofi_icon_fetcher_get_desktop_icon(const gchar* file_path) {
   return icon_key;
 }
 
-static void rofi_icon_fetcher_worker(thread_state *sdata,
-                                     G_GNUC_UNUSED gpointer user_data) {
+static void rofi_icon_fetcher_load(thread_state *sdata,
+                                   G_GNUC_UNUSED gpointer user_data) {
   g_debug("starting up icon fetching thread.");
   // as long as dr->icon is updated atomicly.. (is a pointer write atomic?)
   // this should be fine running in another thread.
@@ -542,7 +543,7 @@ static void rofi_icon_fetcher_worker(thread_state *sdata,
     
     if (strcmp(entry_name, "") == 0) {
       sentry->query_done = TRUE;
-      rofi_view_reload();
+      rofi_view_redraw_rows();
       return;
     }
     
@@ -644,7 +645,7 @@ static void rofi_icon_fetcher_worker(thread_state *sdata,
     // no suitable icon or thumbnail was found
     if (icon_path_ == NULL || !g_file_test(icon_path, G_FILE_TEST_EXISTS)) {
       sentry->query_done = TRUE;
-      rofi_view_reload();
+      rofi_view_redraw_rows();
       return;
     }
   } else if (g_path_is_absolute(sentry->entry->name)) {
@@ -673,7 +674,7 @@ static void rofi_icon_fetcher_worker(thread_state *sdata,
     cairo_destroy(cr);
     sentry->surface = surface;
     sentry->query_done = TRUE;
-    rofi_view_reload();
+    rofi_view_redraw_rows();
     return;
 
   } else {
@@ -692,7 +693,7 @@ static void rofi_icon_fetcher_worker(thread_state *sdata,
       }
       if (icon_path_ == NULL) {
         sentry->query_done = TRUE;
-        rofi_view_reload();
+        rofi_view_redraw_rows();
         return;
       }
     } else {
@@ -707,7 +708,7 @@ static void rofi_icon_fetcher_worker(thread_state *sdata,
   if (suf == NULL) {
     sentry->query_done = TRUE;
     g_free(icon_path_);
-    rofi_view_reload();
+    rofi_view_redraw_rows();
     return;
   }
 #endif
@@ -741,7 +742,13 @@ static void rofi_icon_fetcher_worker(thread_state *sdata,
   sentry->surface = icon_surf;
   g_free(icon_path_);
   sentry->query_done = TRUE;
-  rofi_view_reload();
+  rofi_view_redraw_rows();
+}
+
+static void rofi_icon_fetcher_worker(thread_state *sdata, gpointer user_data) {
+  TRACE_BEGIN("Fetch icon");
+  rofi_icon_fetcher_load(sdata, user_data);
+  TRACE_END("Fetch icon");
 }
 
 uint32_t rofi_icon_fetcher_query_advanced(const char *name, const int wsize,
@@ -601,7 +601,8 @@ static void rofi_collectmodes_dir(const char *base_dir) {
       if (mod) {
         Mode *m = NULL;
         if (g_module_symbol(mod, "mode", (gpointer *)&m)) {
-          if (m->abi_version != ABI_VERSION) {
+          if (m->abi_version < ABI_VERSION_MIN ||
+              m->abi_version > ABI_VERSION) {
             g_warning("ABI version of plugin: '%s' does not match: %08X "
                       "expecting: %08X",
                       dn, m->abi_version, ABI_VERSION);
@@ -776,7 +777,9 @@ static gboolean startup(G_GNUC_UNUSED gpointer data) {
     window_flags |= MENU_TRANSIENT_WINDOW;
   }
   TICK_N("Grab keyboard");
+  TRACE_BEGIN("Create Window");
   __create_window(window_flags);
+  TRACE_END("Create Window");
   TICK_N("Create Window");
   // Parse the keybindings.
   TICK_N("Parse ABE");
@@ -905,6 +908,11 @@ int main(int argc, char *argv[]) {
     }
   }
   TIMINGS_START();
+  char *trace_file = NULL;
+  if (find_arg_str("-trace-file", &trace_file)) {
+    rofi_timings_trace_enable(trace_file);
+  }
+  TRACE_BEGIN("Setup");
 
   // Version
   if (find_arg("-v") >= 0 || find_arg("-version") >= 0) {
@@ -1182,6 +1190,7 @@ int main(int argc, char *argv[]) {
   if (find_arg("-benchmark-ui") >= 0) {
     config.benchmark_ui = TRUE;
   }
+  find_arg_str("-benchmark-replay", &(config.benchmark_replay));
 
   rofi_view_workers_initialize();
   TICK_N("Workers initialize");
@@ -1217,6 +1226,7 @@ int main(int argc, char *argv[]) {
   // SIGINT
   g_unix_signal_add(SIGINT, main_loop_signal_handler_int, NULL);
 
+  TRACE_END("Setup");
   g_idle_add(startup, NULL);
 
   // Start mainloop.
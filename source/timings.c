@@ -31,7 +31,9 @@
 #include "timings.h"
 #include "config.h"
 #include "rofi.h"
+#include <errno.h>
 #include <stdio.h>
+#include <unistd.h>
 /**
  * Timer used to calculate time stamps.
  */
@@ -41,6 +43,164 @@ GTimer *global_timer = NULL;
  */
 double global_timer_last = 0.0;
 
+gint rofi_timings_trace = FALSE;
+
+/**
+ * One event in the trace.
+ */
+typedef struct {
+  /** Chrome trace event phase: 'B' begin, 'E' end, 'i' tick. */
+  char phase;
+  /** Id of the thread. */
+  guint tid;
+  /** Monotonic time (in us). */
+  gint64 ts;
+  /** Name of the span, or the (owned) message of the tick. */
+  const char *name;
+  /** File the tick originates from. */
+  const char *file;
+  /** Function the tick originates from. */
+  const char *func;
+  /** Line the tick originates from. */
+  int line;
+} TraceEvent;
+
+/**
+ * The recorded trace.
+ */
+static struct {
+  /** File to write the trace to. */
+  char *path;
+  /** Protects events and threads. */
+  GMutex mutex;
+  /** Array of #TraceEvent. */
+  GArray *events;
+  /** Number of threads seen. */
+  guint threads;
+} Trace = {.path = NULL, .events = NULL, .threads = 0};
+
+/** Id of the calling thread in the trace, 0 if not seen yet. */
+static GPrivate trace_tid = G_PRIVATE_INIT(NULL);
+
+static void rofi_timings_trace_add(char phase, const char *name,
+                                   const char *file, const char *func,
+                                   int line) {
+  TraceEvent ev = {.phase = phase,
+                   .ts = g_get_monotonic_time(),
+                   .name = name,
+                   .file = file,
+                   .func = func,
+                   .line = line};
+  g_mutex_lock(&(Trace.mutex));
+  if (Trace.events == NULL) {
+    // Stopped.
+    g_mutex_unlock(&(Trace.mutex));
+    if (phase == 'i') {
+      g_free((char *)name);
+    }
+    return;
+  }
+  ev.tid = GPOINTER_TO_UINT(g_private_get(&trace_tid));
+  if (ev.tid == 0) {
+    ev.tid = ++Trace.threads;
+    g_private_set(&trace_tid, GUINT_TO_POINTER(ev.tid));
+  }
+  g_array_append_val(Trace.events, ev);
+  g_mutex_unlock(&(Trace.mutex));
+}
+
+void rofi_timings_trace_enable(const char *path) {
+  g_mutex_lock(&(Trace.mutex));
+  if (Trace.events == NULL) {
+    Trace.path = g_strdup(path);
+    Trace.events = g_array_sized_new(FALSE, FALSE, sizeof(TraceEvent), 1024);
+  }
+  // The main thread is the first one.
+  if (g_private_get(&trace_tid) == NULL) {
+    g_private_set(&trace_tid, GUINT_TO_POINTER(++Trace.threads));
+  }
+  g_mutex_unlock(&(Trace.mutex));
+  g_atomic_int_set(&rofi_timings_trace, TRUE);
+}
+
+void rofi_timings_trace_begin(const char *name) {
+  rofi_timings_trace_add('B', name, NULL, NULL, 0);
+}
+
+void rofi_timings_trace_end(const char *name) {
+  rofi_timings_trace_add('E', name, NULL, NULL, 0);
+}
+
+static void rofi_timings_trace_write_string(FILE *fp, const char *str) {
+  fputc('"', fp);
+  for (const char *c = str; c != NULL && *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      fprintf(fp, "\\%c", *c);
+    } else if ((unsigned char)*c < 0x20) {
+      fprintf(fp, "\\u%04x", (unsigned char)*c);
+    } else {
+      fputc(*c, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+/**
+ * Write the trace to Trace::path and free it.
+ */
+static void rofi_timings_trace_write(void) {
+  g_mutex_lock(&(Trace.mutex));
+  GArray *events = Trace.events;
+  Trace.events = NULL;
+  g_atomic_int_set(&rofi_timings_trace, FALSE);
+  g_mutex_unlock(&(Trace.mutex));
+  if (events == NULL) {
+    return;
+  }
+
+  FILE *fp = fopen(Trace.path, "w");
+  if (fp == NULL) {
+    g_warning("Failed to write trace to '%s': %s", Trace.path,
+              g_strerror(errno));
+  }
+  long pid = (long)getpid();
+  if (fp != NULL) {
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (guint t = 1; t <= Trace.threads; t++) {
+      fprintf(fp,
+              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,"
+              "\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n",
+              pid, t, t == 1 ? "main" : "worker");
+    }
+  }
+  for (guint i = 0; i < events->len; i++) {
+    TraceEvent *ev = &g_array_index(events, TraceEvent, i);
+    if (fp != NULL) {
+      fprintf(fp, "%s{\"name\":", i > 0 ? ",\n" : "");
+      rofi_timings_trace_write_string(fp, ev->name);
+      fprintf(fp,
+              ",\"ph\":\"%c\",\"ts\":%" G_GINT64_FORMAT
+              ",\"pid\":%ld,\"tid\":%u",
+              ev->phase, ev->ts, pid, ev->tid);
+      if (ev->phase == 'i') {
+        fprintf(fp, ",\"s\":\"t\",\"args\":{\"location\":\"%s:%s:%d\"}",
+                ev->file, ev->func, ev->line);
+      }
+      fputc('}', fp);
+    }
+    if (ev->phase == 'i') {
+      g_free((char *)ev->name);
+    }
+  }
+  if (fp != NULL) {
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+  }
+  g_array_free(events, TRUE);
+  g_free(Trace.path);
+  Trace.path = NULL;
+}
+
 void rofi_timings_init(void) {
   global_timer = g_timer_new();
   double now = g_timer_elapsed(global_timer, NULL);
@@ -54,10 +214,15 @@ void rofi_timings_tick(const char *file, char const *str, int line,
   g_debug("%4.6f (%2.6f): %s:%s:%-3d %s", now, now - global_timer_last, file,
           str, line, msg);
   global_timer_last = now;
+  if (G_UNLIKELY(g_atomic_int_get(&rofi_timings_trace))) {
+    rofi_timings_trace_add('i', g_strdup(msg[0] != '\0' ? msg : str), file, str,
+                           line);
+  }
 }
 
 void rofi_timings_quit(void) {
   double now = g_timer_elapsed(global_timer, NULL);
   g_debug("%4.6f (%2.6f): Stopped", now, 0.0);
   g_timer_destroy(global_timer);
+  rofi_timings_trace_write();
 }
@@ -29,6 +29,7 @@
 #define G_LOG_DOMAIN "View"
 
 #include "config.h"
+#include <limits.h>
 #include <locale.h>
 #include <signal.h>
 #include <stdint.h>
@@ -40,6 +41,7 @@
 #ifdef XCB_IMDKIT
 #include <xcb-imdkit/encoding.h>
 #endif
+#include <xcb/xcb_aux.h>
 #include <xcb/xcb_ewmh.h>
 #include <xcb/xcb_icccm.h>
 #include <xcb/xkb.h>
@@ -81,6 +83,13 @@ void rofi_view_update(RofiViewState *state, gboolean qr);
 
 static int rofi_view_calculate_height(RofiViewState *state);
 
+static void filter_job_cancel(RofiViewState *state);
+static void filter_job_finish(RofiViewState *state);
+static gboolean filter_job_done_idle(gpointer data);
+static void rofi_view_refilter_appended(RofiViewState *state);
+static void selection_changed_callback(listview *lv, unsigned int index,
+                                       void *udata);
+
 #ifdef XCB_IMDKIT
 static void xim_commit_string(xcb_xim_t *im, G_GNUC_UNUSED xcb_xic_t ic,
                               G_GNUC_UNUSED uint32_t flag, char *str,
@@ -131,16 +140,11 @@ struct {
   workarea mon;
   /** timeout for reloading */
   guint idle_timeout;
-  /** timeout for reloading */
-  guint refilter_timeout;
-  /** amount of time refiltering delay got reset */
-  guint refilter_timeout_count;
-
-  /** if filtering takes longer then this time,
-   * reduce the amount of refilters. */
-  double max_refilter_time;
-  /** enable the reduced refilter mode. */
-  gboolean delayed_mode;
+  /** If the pending reload only appends rows, see rofi_view_append_rows(). */
+  gboolean reload_append;
+  /** If a redraw of the rows is pending, see rofi_view_redraw_rows(). Set
+   * from any thread, only access it with the g_atomic_int functions. */
+  gint redraw_rows;
   /** timeout handling */
   guint user_timeout;
   /** debug counter for redraws */
@@ -167,10 +171,6 @@ struct {
                 .flags = MENU_NORMAL,
                 .views = G_QUEUE_INIT,
                 .idle_timeout = 0,
-                .refilter_timeout = 0,
-                .refilter_timeout_count = 0,
-                .max_refilter_time = 0.0,
-                .delayed_mode = FALSE,
                 .user_timeout = 0,
                 .count = 0L,
                 .repaint_source = 0,
@@ -209,7 +209,143 @@ static int lev_sort(const void *p1, const void *p2, void *arg) {
   const int *b = p2;
   int *distances = arg;
 
-  return distances[*a] - distances[*b];
+  if (distances[*a] != distances[*b]) {
+    return distances[*a] - distances[*b];
+  }
+  // Keep equal scores in list order, so the result does not depend on the
+  // order of the set it was filtered from.
+  return (*a > *b) - (*a < *b);
+}
+
+/** Extra rows ranked beyond the ones needed, so scrolling does not rank. */
+#define RANK_MARGIN 64
+
+/**
+ * @param lines The rows to partition.
+ * @param n Number of rows.
+ * @param k Number of rows wanted.
+ * @param distances The sort keys, see lev_sort.
+ *
+ * Quickselect, afterwards the first k rows are the k lowest (unordered).
+ */
+static void rank_select(unsigned int *lines, unsigned int n, unsigned int k,
+                        int *distances) {
+  unsigned int lo = 0, hi = n;
+  while (k > lo && k < hi && (hi - lo) > 1) {
+    // Median of three as pivot, moved to the end.
+    unsigned int mid = lo + (hi - lo) / 2;
+    unsigned int tmp;
+    if (lev_sort(&lines[mid], &lines[lo], distances) < 0) {
+      tmp = lines[mid], lines[mid] = lines[lo], lines[lo] = tmp;
+    }
+    if (lev_sort(&lines[hi - 1], &lines[lo], distances) < 0) {
+      tmp = lines[hi - 1], lines[hi - 1] = lines[lo], lines[lo] = tmp;
+    }
+    if (lev_sort(&lines[mid], &lines[hi - 1], distances) < 0) {
+      tmp = lines[mid], lines[mid] = lines[hi - 1], lines[hi - 1] = tmp;
+    }
+    unsigned int store = lo;
+    for (unsigned int i = lo; i < hi - 1; i++) {
+      if (lev_sort(&lines[i], &lines[hi - 1], distances) < 0) {
+        tmp = lines[i], lines[i] = lines[store], lines[store] = tmp;
+        store++;
+      }
+    }
+    tmp = lines[hi - 1], lines[hi - 1] = lines[store], lines[store] = tmp;
+    if (store < k) {
+      lo = store + 1;
+    } else {
+      hi = store;
+    }
+  }
+}
+
+/**
+ * @param state The Menu Handle
+ * @param needed Number of rows that need to be in order.
+ *
+ * When sorting, only the rows that are shown are put in order after
+ * filtering. Extend the ordered part of line_map when rows beyond it are
+ * needed. The window at least doubles each time, so paging through the
+ * whole list costs about one full sort.
+ */
+static void rofi_view_rank_lines(RofiViewState *state, unsigned int needed) {
+  if (needed <= state->ranked_lines ||
+      state->ranked_lines >= state->filtered_lines) {
+    return;
+  }
+  unsigned int k = MAX(needed + RANK_MARGIN, 2 * state->ranked_lines);
+  k = MIN(k, state->filtered_lines);
+  unsigned int *base = &(state->line_map[state->ranked_lines]);
+  rank_select(base, state->filtered_lines - state->ranked_lines,
+              k - state->ranked_lines, state->distance);
+  g_qsort_with_data(base, k - state->ranked_lines, sizeof(unsigned int),
+                    lev_sort, state->distance);
+  state->ranked_lines = k;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param rows The matching rows to add.
+ * @param count Number of rows.
+ * @param sort If the result is sorted.
+ *
+ * Add the matches among rows appended to the mode to the current result.
+ * When sorting, the new rows that sort before the last ranked row are merged
+ * into the ranked part, the others join the unranked rest. This costs the
+ * new rows and the ranked part, not the whole result.
+ */
+static void rofi_view_filter_add_rows(RofiViewState *state,
+                                      const unsigned int *rows,
+                                      unsigned int count, unsigned int sort) {
+  unsigned int *lines = state->line_map;
+  unsigned int first = state->filtered_lines;
+  unsigned int r = state->ranked_lines;
+  memcpy(&(lines[first]), rows, sizeof(unsigned int) * count);
+  state->filtered_lines += count;
+  if (!sort) {
+    state->ranked_lines = state->filtered_lines;
+    return;
+  }
+  // Move the rows that belong in the ranked part right behind it.
+  unsigned int k = 0;
+  for (unsigned int i = first; i < first + count; i++) {
+    if (r == first ||
+        (r > 0 && lev_sort(&lines[i], &lines[r - 1], state->distance) < 0)) {
+      unsigned int tmp = lines[i];
+      lines[i] = lines[r + k];
+      lines[r + k] = tmp;
+      k++;
+    }
+  }
+  if (k == 0) {
+    return;
+  }
+  g_qsort_with_data(&lines[r], k, sizeof(unsigned int), lev_sort,
+                    state->distance);
+  // Merge them into the ranked part, from the back.
+  unsigned int *added = g_memdup2(&lines[r], sizeof(unsigned int) * k);
+  unsigned int i = r, j = k, w = r + k;
+  while (j > 0) {
+    if (i > 0 && lev_sort(&lines[i - 1], &added[j - 1], state->distance) > 0) {
+      lines[--w] = lines[--i];
+    } else {
+      lines[--w] = added[--j];
+    }
+  }
+  g_free(added);
+  state->ranked_lines = r + k;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param index Index in the filtered list.
+ *
+ * @returns the row shown at index.
+ */
+static unsigned int rofi_view_line(RofiViewState *state, unsigned int index) {
+  rofi_view_rank_lines(state, index + 1);
+  return state->line_map[index];
 }
 
 /**
@@ -320,6 +456,281 @@ static gboolean bench_update(void) {
   return TRUE;
 }
 
+/** Type of a #ReplayEvent. */
+typedef enum {
+  /** Type text into the input bar. */
+  REPLAY_TEXT,
+  /** Trigger a key binding. */
+  REPLAY_KEY,
+  /** Move the mouse, optionally triggering a mouse binding. */
+  REPLAY_MOUSE,
+} ReplayEventType;
+
+/**
+ * One input event of a replay script, see -benchmark-replay.
+ */
+typedef struct {
+  /** The type of event. */
+  ReplayEventType type;
+  /** The text to type. */
+  char *text;
+  /** The action to trigger, UINT32_MAX for none. */
+  guint action;
+  /** The scope of the action. */
+  BindingsScope scope;
+  /** Mouse X position. */
+  int x;
+  /** Mouse Y position. */
+  int y;
+  /** Time (in ms) to wait before the event. */
+  guint delay;
+} ReplayEvent;
+
+/**
+ * Internal structure that holds the state of the input replay.
+ */
+static struct {
+  /** The #ReplayEvent to replay. */
+  GPtrArray *events;
+  /** Index of the next event. */
+  guint next;
+  /** Timeout injecting the next event. */
+  guint source;
+  /** Monotonic time the last event was injected, 0 if it is presented. */
+  gint64 input;
+  /** Time spent in rofi_view_update() since the last event. */
+  gint64 update;
+  /** Time (in us) from the event to the presented frame, per event. */
+  GArray *latency;
+  /** Time (in us) spent refiltering, per event. */
+  GArray *refilter;
+  /** Time (in us) spent drawing, per event. */
+  GArray *draw;
+  /** Time (in us) spent presenting the frame, per event. */
+  GArray *present;
+} Replay = {.events = NULL, .next = 0, .source = 0, .input = 0};
+
+static void replay_event_free(gpointer data) {
+  ReplayEvent *ev = (ReplayEvent *)data;
+  g_free(ev->text);
+  g_free(ev);
+}
+
+/**
+ * @param path The script to load.
+ *
+ * Load a replay script. Each line holds one event:
+ * `text <string>`, `key <binding>`, `mouse <x> <y> [<binding>]` or
+ * `wait <ms>` to delay the next event. Empty lines and lines starting with
+ * `#` are skipped.
+ *
+ * @returns the events, or NULL on error.
+ */
+static GPtrArray *replay_load(const char *path) {
+  GError *error = NULL;
+  char *content = NULL;
+  if (!g_file_get_contents(path, &content, NULL, &error)) {
+    g_warning("Failed to read replay script '%s': %s", path, error->message);
+    g_error_free(error);
+    return NULL;
+  }
+  GPtrArray *events = g_ptr_array_new_with_free_func(replay_event_free);
+  char **lines = g_strsplit(content, "\n", -1);
+  guint delay = 0;
+  for (guint i = 0; lines[i] != NULL; i++) {
+    char *line = g_strstrip(lines[i]);
+    if (line[0] == '\0' || line[0] == '#') {
+      continue;
+    }
+    char *arg = line + strcspn(line, " \t");
+    if (*arg != '\0') {
+      *arg = '\0';
+      arg = g_strchug(arg + 1);
+    }
+    ReplayEvent ev = {.action = UINT32_MAX, .scope = SCOPE_GLOBAL};
+    char name[64] = "";
+    if (g_strcmp0(line, "wait") == 0) {
+      delay += (guint)g_ascii_strtoull(arg, NULL, 10);
+      continue;
+    }
+    if (g_strcmp0(line, "text") == 0 && *arg != '\0') {
+      ev.type = REPLAY_TEXT;
+      ev.text = g_strcompress(arg);
+    } else if (g_strcmp0(line, "key") == 0) {
+      ev.type = REPLAY_KEY;
+      ev.action = key_binding_get_action_from_name(arg);
+      ev.scope = key_binding_get_scope_from_name(arg);
+      g_strlcpy(name, arg, sizeof(name));
+    } else if (g_strcmp0(line, "mouse") == 0 &&
+               sscanf(arg, "%d %d %63s", &(ev.x), &(ev.y), name) >= 2) {
+      ev.type = REPLAY_MOUSE;
+      if (name[0] != '\0') {
+        ev.action = key_binding_get_action_from_name(name);
+        ev.scope = key_binding_get_scope_from_name(name);
+      }
+    } else {
+      g_warning("%s:%u: Invalid replay event: '%s'", path, i + 1, line);
+      g_ptr_array_free(events, TRUE);
+      events = NULL;
+      break;
+    }
+    if (name[0] != '\0' && ev.action == UINT32_MAX) {
+      g_warning("%s:%u: Unknown key binding: '%s'", path, i + 1, name);
+      g_ptr_array_free(events, TRUE);
+      events = NULL;
+      break;
+    }
+    ev.delay = delay;
+    delay = 0;
+    g_ptr_array_add(events, g_memdup2(&ev, sizeof(ev)));
+  }
+  g_strfreev(lines);
+  g_free(content);
+  return events;
+}
+
+static gboolean replay_next(G_GNUC_UNUSED gpointer data) {
+  Replay.source = 0;
+  RofiViewState *state = current_active_menu;
+  if (state == NULL) {
+    return G_SOURCE_REMOVE;
+  }
+  ReplayEvent *ev = g_ptr_array_index(Replay.events, Replay.next);
+  Replay.next++;
+  Replay.update = 0;
+  Replay.input = g_get_monotonic_time();
+  switch (ev->type) {
+  case REPLAY_TEXT:
+    rofi_view_handle_text(state, ev->text);
+    break;
+  case REPLAY_MOUSE:
+    rofi_view_handle_mouse_motion(state, ev->x, ev->y, config.hover_select);
+    if (ev->action == UINT32_MAX) {
+      break;
+    }
+  /* FALLTHRU */
+  case REPLAY_KEY:
+    rofi_view_trigger_action(state, ev->scope, ev->action);
+    break;
+  }
+  // Like after an X11 event, see main_loop_x11_event_handler_view().
+  rofi_view_maybe_update(state);
+  rofi_view_queue_redraw();
+  return G_SOURCE_REMOVE;
+}
+
+static void replay_schedule(void) {
+  ReplayEvent *ev = g_ptr_array_index(Replay.events, Replay.next);
+  Replay.source = g_timeout_add(ev->delay, replay_next, NULL);
+}
+
+static int replay_cmp(gconstpointer a, gconstpointer b) {
+  gint64 va = *(const gint64 *)a, vb = *(const gint64 *)b;
+  return (va > vb) - (va < vb);
+}
+
+static void replay_print_percentiles(const char *name, GArray *values) {
+  g_array_sort(values, replay_cmp);
+  printf(",\"%s_us\":{", name);
+  const unsigned int percentiles[] = {50, 95, 99};
+  for (size_t i = 0; i < G_N_ELEMENTS(percentiles); i++) {
+    // Nearest rank.
+    guint rank = (percentiles[i] * values->len + 99) / 100;
+    gint64 v = values->len > 0 ? g_array_index(values, gint64, rank - 1) : 0;
+    printf("%s\"p%u\":%" G_GINT64_FORMAT, i > 0 ? "," : "", percentiles[i], v);
+  }
+  printf("}");
+}
+
+/**
+ * Print the latency percentiles of the replayed events as a JSON object and
+ * free the replay.
+ */
+static void replay_report(void) {
+  if (Replay.events == NULL) {
+    return;
+  }
+  if (Replay.source > 0) {
+    g_source_remove(Replay.source);
+    Replay.source = 0;
+  }
+  printf("{\"events\":%u,\"presented\":%u", Replay.events->len,
+         Replay.latency->len);
+  replay_print_percentiles("latency", Replay.latency);
+  replay_print_percentiles("refilter", Replay.refilter);
+  replay_print_percentiles("draw", Replay.draw);
+  replay_print_percentiles("present", Replay.present);
+  printf("}\n");
+  fflush(stdout);
+
+  g_ptr_array_free(Replay.events, TRUE);
+  Replay.events = NULL;
+  g_array_free(Replay.latency, TRUE);
+  g_array_free(Replay.refilter, TRUE);
+  g_array_free(Replay.draw, TRUE);
+  g_array_free(Replay.present, TRUE);
+}
+
+/**
+ * Start replaying the script set with -benchmark-replay, once.
+ */
+static void replay_start(void) {
+  static gboolean started = FALSE;
+  if (config.benchmark_replay == NULL || started) {
+    return;
+  }
+  started = TRUE;
+  Replay.events = replay_load(config.benchmark_replay);
+  if (Replay.events == NULL || Replay.events->len == 0) {
+    g_clear_pointer(&(Replay.events), g_ptr_array_unref);
+    return;
+  }
+  Replay.latency = g_array_new(FALSE, FALSE, sizeof(gint64));
+  Replay.refilter = g_array_new(FALSE, FALSE, sizeof(gint64));
+  Replay.draw = g_array_new(FALSE, FALSE, sizeof(gint64));
+  Replay.present = g_array_new(FALSE, FALSE, sizeof(gint64));
+  Replay.next = 0;
+  replay_schedule();
+}
+
+/**
+ * @param state The view that was presented.
+ * @param present The monotonic time presenting the frame started.
+ *
+ * Called after a frame is presented. Once the last event is handled
+ * completely, record its timings and inject the next one.
+ */
+static void replay_presented(RofiViewState *state, gint64 present) {
+  if (Replay.events == NULL || Replay.input == 0) {
+    return;
+  }
+  if (state->refilter || state->append || state->filter_job != NULL) {
+    // Not the result of the event yet.
+    return;
+  }
+  gint64 now = g_get_monotonic_time();
+  gint64 latency = now - Replay.input;
+  gint64 refilter = 0;
+  if (state->filter_timings.start >= Replay.input) {
+    refilter = state->filter_timings.filter + state->filter_timings.sort +
+               state->filter_timings.listview + state->filter_timings.resize;
+  }
+  present = now - present;
+  g_array_append_val(Replay.latency, latency);
+  g_array_append_val(Replay.refilter, refilter);
+  g_array_append_val(Replay.draw, Replay.update);
+  g_array_append_val(Replay.present, present);
+  Replay.input = 0;
+
+  if (Replay.next < Replay.events->len) {
+    replay_schedule();
+    return;
+  }
+  replay_report();
+  rofi_view_trigger_action(state, SCOPE_GLOBAL, CANCEL);
+  rofi_view_maybe_update(state);
+}
+
 static gboolean rofi_view_repaint(G_GNUC_UNUSED void *data) {
   if (current_active_menu) {
     // Repaint the view (if needed).
@@ -330,12 +741,23 @@ static gboolean rofi_view_repaint(G_GNUC_UNUSED void *data) {
     rofi_view_update(current_active_menu, FALSE);
     g_debug("expose event");
     TICK_N("Expose");
-    xcb_copy_area(xcb->connection, CacheState.edit_pixmap,
-                  CacheState.main_window, CacheState.gc, 0, 0, 0, 0,
-                  current_active_menu->width, current_active_menu->height);
-    xcb_flush(xcb->connection);
+    gint64 present = g_get_monotonic_time();
+    TRACE_BEGIN("Present");
+    if (CacheState.main_window != XCB_WINDOW_NONE) {
+      xcb_copy_area(xcb->connection, CacheState.edit_pixmap,
+                    CacheState.main_window, CacheState.gc, 0, 0, 0, 0,
+                    current_active_menu->width, current_active_menu->height);
+      if (Replay.input != 0) {
+        // Wait for the server to have done the copy.
+        xcb_aux_sync(xcb->connection);
+      } else {
+        xcb_flush(xcb->connection);
+      }
+    }
+    TRACE_END("Present");
     TICK_N("flush");
     CacheState.repaint_source = 0;
+    replay_presented(current_active_menu, present);
   }
   return (bench_update() == TRUE) ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
 }
@@ -454,6 +876,16 @@ static void rofi_view_window_update_size(RofiViewState *state) {
   if (state == NULL) {
     return;
   }
+  if (CacheState.main_window == XCB_WINDOW_NONE) {
+    // Headless, see rofi_view_create_headless().
+    cairo_destroy(CacheState.edit_draw);
+    cairo_surface_destroy(CacheState.edit_surf);
+    CacheState.edit_surf = cairo_image_surface_create(
+        CAIRO_FORMAT_ARGB32, state->width, state->height);
+    CacheState.edit_draw = cairo_create(CacheState.edit_surf);
+    widget_resize(WIDGET(state->main_window), state->width, state->height);
+    return;
+  }
   uint16_t mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
                   XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
   uint32_t vals[] = {state->x, state->y, state->width, state->height};
@@ -526,11 +958,16 @@ static gboolean rofi_view_reload_idle(G_GNUC_UNUSED gpointer data) {
       textbox_text(current_active_menu->tb_total_rows, r);
       g_free(r);
     }
-    current_active_menu->reload = TRUE;
-    current_active_menu->refilter = TRUE;
+    if (CacheState.reload_append) {
+      current_active_menu->append = TRUE;
+    } else {
+      current_active_menu->reload = TRUE;
+      current_active_menu->refilter = TRUE;
+    }
     rofi_view_queue_redraw();
   }
   CacheState.idle_timeout = 0;
+  CacheState.reload_append = FALSE;
   return G_SOURCE_REMOVE;
 }
 
@@ -583,13 +1020,54 @@ static void rofi_view_set_user_timeout(G_GNUC_UNUSED gpointer data) {
   }
 }
 
+static gboolean rofi_view_reload_main(G_GNUC_UNUSED gpointer data) {
+  rofi_view_reload();
+  return G_SOURCE_REMOVE;
+}
+
 void rofi_view_reload(void) {
   // @TODO add check if current view is equal to the callee
+  if (!g_main_context_is_owner(NULL)) {
+    // The reload state belongs to the main loop, icons load on workers.
+    g_idle_add(rofi_view_reload_main, NULL);
+    return;
+  }
+  // A full reload also picks up appended rows.
+  CacheState.reload_append = FALSE;
   if (CacheState.idle_timeout == 0) {
     CacheState.idle_timeout =
         g_timeout_add(1000 / 100, rofi_view_reload_idle, NULL);
   }
 }
+
+static gboolean rofi_view_redraw_rows_idle(G_GNUC_UNUSED gpointer data) {
+  g_atomic_int_set(&(CacheState.redraw_rows), FALSE);
+  RofiViewState *state = current_active_menu;
+  if (state && state->list_view) {
+    // Drawing fetches the icons of the rows again, nothing is filtered.
+    selection_changed_callback(state->list_view,
+                               listview_get_selected(state->list_view), state);
+    widget_queue_redraw(WIDGET(state->list_view));
+    rofi_view_queue_redraw();
+  }
+  return G_SOURCE_REMOVE;
+}
+
+void rofi_view_redraw_rows(void) {
+  // Multiple requests are handled at once, like rofi_view_reload().
+  if (g_atomic_int_compare_and_exchange(&(CacheState.redraw_rows), FALSE,
+                                        TRUE)) {
+    g_timeout_add(1000 / 100, rofi_view_redraw_rows_idle, NULL);
+  }
+}
+
+void rofi_view_append_rows(void) {
+  if (CacheState.idle_timeout == 0) {
+    CacheState.reload_append = TRUE;
+    CacheState.idle_timeout =
+        g_timeout_add(1000 / 100, rofi_view_reload_idle, NULL);
+  }
+}
 void rofi_view_queue_redraw(void) {
   if (current_active_menu && CacheState.repaint_source == 0) {
     CacheState.count++;
@@ -615,6 +1093,7 @@ void rofi_view_remove_active(RofiViewState *state) {
 }
 void rofi_view_set_active(RofiViewState *state) {
   if (current_active_menu != NULL && state != NULL) {
+    filter_job_finish(current_active_menu);
     g_queue_push_head(&(CacheState.views), current_active_menu);
     // TODO check.
     current_active_menu = state;
@@ -641,6 +1120,9 @@ void rofi_view_set_selected_line(RofiViewState *state,
   state->selected_line = selected_line;
   // Find the line.
   unsigned int selected = 0;
+  if (state->selected_line < UINT32_MAX) {
+    rofi_view_rank_lines(state, state->filtered_lines);
+  }
   for (unsigned int i = 0; ((state->selected_line)) < UINT32_MAX && !selected &&
                            i < state->filtered_lines;
        i++) {
@@ -650,15 +1132,307 @@ void rofi_view_set_selected_line(RofiViewState *state,
     }
   }
   listview_set_selected(state->list_view, selected);
-  xcb_clear_area(xcb->connection, CacheState.main_window, 1, 0, 0, 1, 1);
-  xcb_flush(xcb->connection);
+  if (CacheState.main_window != XCB_WINDOW_NONE) {
+    xcb_clear_area(xcb->connection, CacheState.main_window, 1, 0, 0, 1, 1);
+    xcb_flush(xcb->connection);
+  }
 }
 
-void rofi_view_free(RofiViewState *state) {
+/**
+ * @param state The Menu Handle
+ *
+ * Forget the previous filter pass, so the next pass filters all rows.
+ */
+static void rofi_view_prev_filter_clear(RofiViewState *state) {
+  g_free(state->prev_filter.input);
+  g_free(state->prev_filter.pattern);
+  state->prev_filter.input = NULL;
+  state->prev_filter.pattern = NULL;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param input The raw user input, taken over.
+ * @param pattern The preprocessed user input, taken over.
+ * @param case_sensitive Case sensitivity of the pass.
+ * @param sort If the result was sorted.
+ * @param matching_method Matching method used.
+ *
+ * Remember the query of the current result, to narrow the next pass.
+ */
+static void rofi_view_prev_filter_set(RofiViewState *state, char *input,
+                                      char *pattern, int case_sensitive,
+                                      unsigned int sort,
+                                      MatchingMethod matching_method) {
+  rofi_view_prev_filter_clear(state);
+  state->prev_filter.input = input;
+  state->prev_filter.pattern = pattern;
+  state->prev_filter.case_sensitive = case_sensitive;
+  state->prev_filter.sort = sort;
+  state->prev_filter.matching_method = matching_method;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param input The raw user input.
+ * @param pattern The preprocessed user input.
+ *
+ * If the new query can only match a subset of what the previous query
+ * matched, the previous result can be filtered instead of all rows.
+ * This holds when both the input and the pattern extend the previous ones,
+ * the settings did not change, the matching method is monotone (regex is
+ * not) and no token is negated (a longer negated token matches more).
+ *
+ * @returns TRUE if the previous result can be narrowed.
+ */
+static gboolean rofi_view_prev_filter_can_narrow(RofiViewState *state,
+                                                 const char *input,
+                                                 const char *pattern) {
+  if (state->prev_filter.input == NULL || pattern == NULL) {
+    return FALSE;
+  }
+  if (state->prev_filter.case_sensitive != config.case_sensitive ||
+      state->prev_filter.sort != config.sort ||
+      state->prev_filter.matching_method != config.matching_method) {
+    return FALSE;
+  }
+  switch (config.matching_method) {
+  case MM_NORMAL:
+  case MM_PREFIX:
+  case MM_GLOB:
+  case MM_FUZZY:
+    break;
+  default:
+    return FALSE;
+  }
+  const char *prev_pattern =
+      state->prev_filter.pattern ? state->prev_filter.pattern : "";
+  if (!g_str_has_prefix(input, state->prev_filter.input) ||
+      !g_str_has_prefix(pattern, prev_pattern)) {
+    return FALSE;
+  }
+  for (const char *iter = pattern; *iter != '\0'; iter++) {
+    if (*iter == config.matching_negate_char &&
+        (iter == pattern || (config.tokenize && iter[-1] == ' '))) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/** Maximum number of filter results kept per view. */
+#define FILTER_CACHE_MAX_ENTRIES 32
+/** Maximum number of bytes of filter results kept per view. */
+#define FILTER_CACHE_MAX_SIZE (16u * 1024 * 1024)
+
+/**
+ * The result of an earlier filter pass, so going back to an earlier query
+ * (backspace, entry history) does not filter again.
+ */
+typedef struct {
+  /** The mode that was filtered. */
+  const Mode *sw;
+  /** The input after mode preprocessing. */
+  char *pattern;
+  /** Case sensitivity the pass was done with. */
+  int case_sensitive;
+  /** Matching method used. */
+  MatchingMethod matching_method;
+  /** If the result was sorted. */
+  unsigned int sort;
+  /** Sorting method used. */
+  SortingMethod sorting_method;
+  /** Number of matching rows. */
+  unsigned int filtered_lines;
+  /** The matching rows, unranked. */
+  unsigned int *line_map;
+  /** Sort distance of each matching row, NULL if not sorted. */
+  int *distance;
+  /** Number of bytes held by the entry. */
+  gsize size;
+} FilterCacheEntry;
+
+static void filter_cache_entry_free(FilterCacheEntry *entry) {
+  g_free(entry->pattern);
+  g_free(entry->line_map);
+  g_free(entry->distance);
+  g_free(entry);
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Drop all cached filter results, e.g. when the rows changed.
+ */
+static void rofi_view_filter_cache_clear(RofiViewState *state) {
+  g_queue_clear_full(&(state->filter_cache),
+                     (GDestroyNotify)filter_cache_entry_free);
+  state->filter_cache_size = 0;
+}
+
+/**
+ * @param a A filter cache entry.
+ * @param b A filter cache entry.
+ *
+ * @returns TRUE if both are the result of the same query.
+ */
+static gboolean filter_cache_entry_same_query(const FilterCacheEntry *a,
+                                              const FilterCacheEntry *b) {
+  return a->sw == b->sw && a->sort == b->sort &&
+         a->case_sensitive == b->case_sensitive &&
+         a->matching_method == b->matching_method &&
+         (!a->sort || a->sorting_method == b->sorting_method) &&
+         g_strcmp0(a->pattern, b->pattern) == 0;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param key The query to look for, only the query fields are used.
+ *
+ * @returns the link of the cached result of the query, or NULL.
+ */
+static GList *rofi_view_filter_cache_find(RofiViewState *state,
+                                          const FilterCacheEntry *key) {
+  for (GList *iter = g_queue_peek_head_link(&(state->filter_cache));
+       iter != NULL; iter = g_list_next(iter)) {
+    if (filter_cache_entry_same_query(iter->data, key)) {
+      return iter;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param key The query of the current result, only the query fields are used.
+ *
+ * Store the (unranked) current result of the view, evicting the least
+ * recently used results to stay within the limits.
+ */
+static void rofi_view_filter_cache_store(RofiViewState *state,
+                                         const FilterCacheEntry *key) {
+  gsize size = sizeof(FilterCacheEntry) +
+               (key->pattern ? strlen(key->pattern) : 0) +
+               (gsize)state->filtered_lines * sizeof(unsigned int);
+  if (key->sort) {
+    size += (gsize)state->filtered_lines * sizeof(int);
+  }
+  if (size > FILTER_CACHE_MAX_SIZE / 4) {
+    return;
+  }
+  GList *old = rofi_view_filter_cache_find(state, key);
+  if (old != NULL) {
+    FilterCacheEntry *entry = old->data;
+    state->filter_cache_size -= entry->size;
+    filter_cache_entry_free(entry);
+    g_queue_delete_link(&(state->filter_cache), old);
+  }
+  while (state->filter_cache.length >= FILTER_CACHE_MAX_ENTRIES ||
+         (state->filter_cache.length > 0 &&
+          state->filter_cache_size + size > FILTER_CACHE_MAX_SIZE)) {
+    FilterCacheEntry *entry = g_queue_pop_tail(&(state->filter_cache));
+    state->filter_cache_size -= entry->size;
+    filter_cache_entry_free(entry);
+  }
+  FilterCacheEntry *entry = g_memdup2(key, sizeof(FilterCacheEntry));
+  entry->pattern = g_strdup(key->pattern);
+  entry->filtered_lines = state->filtered_lines;
+  entry->line_map = g_memdup2(state->line_map, sizeof(unsigned int) *
+                                                   state->filtered_lines);
+  entry->distance = NULL;
+  if (entry->sort) {
+    // Only the distance of matching rows, in line_map order.
+    entry->distance = g_malloc_n(MAX(1, state->filtered_lines), sizeof(int));
+    for (unsigned int i = 0; i < state->filtered_lines; i++) {
+      entry->distance[i] = state->distance[state->line_map[i]];
+    }
+  }
+  entry->size = size;
+  state->filter_cache_size += size;
+  g_queue_push_head(&(state->filter_cache), entry);
+}
+
+/** Maximum number of rows in the highlight cache. */
+#define HIGHLIGHT_CACHE_MAX_ROWS 1024
+
+/**
+ * The spans to highlight in the drawn text of a row.
+ */
+typedef struct {
+  /** The text the spans were found in. */
+  char *text;
+  /** Array of #RofiMatchSpan. */
+  GArray *spans;
+} HighlightCacheEntry;
+
+static void highlight_cache_entry_free(gpointer data) {
+  HighlightCacheEntry *entry = (HighlightCacheEntry *)data;
+  g_free(entry->text);
+  g_array_free(entry->spans, TRUE);
+  g_free(entry);
+}
+
+/**
+ * @param state The Menu Handle
+ * @param tokens The new tokens (or NULL), taken over.
+ *
+ * Set the tokens used to highlight the rows. The match spans found with the
+ * old tokens are dropped.
+ */
+static void rofi_view_set_tokens(RofiViewState *state,
+                                 rofi_int_matcher **tokens) {
   if (state->tokens) {
     helper_tokenize_free(state->tokens);
-    state->tokens = NULL;
   }
+  state->tokens = tokens;
+  if (state->highlight_cache) {
+    g_hash_table_remove_all(state->highlight_cache);
+  }
+}
+
+/**
+ * @param state The Menu Handle
+ * @param row The row drawn.
+ * @param text The drawn text of the row.
+ *
+ * Get the spans of text matched by the tokens. They are kept per row, so
+ * redrawing a row (moving the selection, scrolling back) does not match the
+ * text again.
+ *
+ * @returns the array of #RofiMatchSpan, owned by the view.
+ */
+static const GArray *rofi_view_highlight_spans(RofiViewState *state,
+                                               unsigned int row,
+                                               const char *text) {
+  if (state->highlight_cache == NULL) {
+    state->highlight_cache = g_hash_table_new_full(
+        g_direct_hash, g_direct_equal, NULL, highlight_cache_entry_free);
+  }
+  HighlightCacheEntry *entry =
+      g_hash_table_lookup(state->highlight_cache, GUINT_TO_POINTER(row));
+  if (entry != NULL && g_strcmp0(entry->text, text) == 0) {
+    return entry->spans;
+  }
+  if (entry == NULL &&
+      g_hash_table_size(state->highlight_cache) >= HIGHLIGHT_CACHE_MAX_ROWS) {
+    g_hash_table_remove_all(state->highlight_cache);
+  }
+  entry = g_malloc0(sizeof(HighlightCacheEntry));
+  entry->text = g_strdup(text);
+  entry->spans = helper_token_match_get_spans(state->tokens, text);
+  g_hash_table_replace(state->highlight_cache, GUINT_TO_POINTER(row), entry);
+  return entry->spans;
+}
+
+void rofi_view_free(RofiViewState *state) {
+  filter_job_cancel(state);
+  rofi_view_set_tokens(state, NULL);
+  if (state->highlight_cache) {
+    g_hash_table_destroy(state->highlight_cache);
+    state->highlight_cache = NULL;
+  }
+  rofi_view_prev_filter_clear(state);
+  rofi_view_filter_cache_clear(state);
   // Do this here?
   // Wait for final release?
   widget_free(WIDGET(state->main_window));
@@ -680,11 +1454,11 @@ unsigned int rofi_view_get_selected_line(const RofiViewState *state) {
   return state->selected_line;
 }
 
-unsigned int rofi_view_get_next_position(const RofiViewState *state) {
+unsigned int rofi_view_get_next_position(RofiViewState *state) {
   unsigned int next_pos = state->selected_line;
   unsigned int selected = listview_get_selected(state->list_view);
   if ((selected + 1) < state->num_lines) {
-    (next_pos) = state->line_map[selected + 1];
+    (next_pos) = rofi_view_line(state, selected + 1);
   }
   return next_pos;
 }
@@ -709,33 +1483,96 @@ static RofiViewState *__rofi_view_state_create(void) {
   return g_malloc0(sizeof(RofiViewState));
 }
 
+/** Number of rows in one chunk of filter work. */
+#define FILTER_CHUNK_SIZE 256
+
 /**
- * Thread state for workers started for the view.
+ * A filter pass, shared by all workers.
+ * The rows are split in fixed size chunks, workers take the next chunk from a
+ * shared cursor until all are taken. A slow chunk only delays the worker that
+ * runs it, the others keep going.
+ *
+ * The pass owns its input and output, so it can run while the main loop keeps
+ * handling input and drawing the previous result. It is cancelled by taking
+ * all chunks nobody started on.
  */
-typedef struct _thread_state_view {
-  /** Generic thread state. */
-  thread_state st;
-
-  /** Condition. */
-  GCond *cond;
-  /** Lock for condition. */
-  GMutex *mutex;
-  /** Count that is protected by lock. */
-  unsigned int *acount;
-
+typedef struct _filter_job {
   /** Current state. */
   RofiViewState *state;
-  /** Start row for this worker. */
-  unsigned int start;
-  /** Stop row for this worker. */
-  unsigned int stop;
-  /** Rows processed. */
-  unsigned int count;
-
+  /** Generation of the pass, see RofiViewState::filter_generation. */
+  unsigned int generation;
+  /** Mode to filter. */
+  Mode *sw;
+  /** The raw user input. */
+  char *input;
   /** Pattern input to filter. */
-  const char *pattern;
+  char *pattern;
   /** Length of pattern. */
   glong plen;
+  /** Tokens to match. */
+  rofi_int_matcher **tokens;
+  /** If the rows are matched against columns, instead of per row callbacks. */
+  gboolean use_columns;
+  /** The matchable fields exported by the mode, see mode_get_columns(). */
+  ModeColumns columns;
+  /** Case sensitivity of the tokens. */
+  int case_sensitive;
+  /** Matching method of the tokens. */
+  MatchingMethod matching_method;
+  /** If the result gets sorted. */
+  unsigned int sort;
+  /** Sorting method. */
+  SortingMethod sorting_method;
+  /** Pattern prepared for levenshtein sorting. */
+  RofiLevenshteinNeedle *lev_needle;
+  /** The rows to filter when narrowing the previous result or found in the
+   * trigram index, NULL for all. */
+  unsigned int *candidate_map;
+  /** Number of candidate rows. */
+  unsigned int candidates;
+  /** Number of rows in the mode. */
+  unsigned int num_lines;
+  /** Rows before it are already filtered, the pass only adds to their result
+   * (see rofi_view_append_rows()). */
+  unsigned int first_row;
+  /** Matching rows, for each chunk stored from the start of the chunk. */
+  unsigned int *line_map;
+  /** Sort distance of each row from first_row on, only set for matching
+   * rows. */
+  int *distance;
+  /** Number of chunks. */
+  unsigned int num_chunks;
+  /** Matches found per chunk, stored at the start of the chunk. */
+  unsigned int *chunk_count;
+  /** Next chunk to take. */
+  gint cursor;
+  /** Number of chunks done. */
+  gint done;
+  /** Set when the result is no longer wanted, or already taken. */
+  gint cancelled;
+  /** Set while the mode appends rows, see filter_job_pause(). */
+  gint paused;
+  /** Chunks taken before the pass was paused. Main thread only. */
+  unsigned int paused_cursor;
+  /** Nobody waits for the pass, the last chunk reports to the main loop.
+   * Protected by mutex. */
+  gboolean background;
+  /** References held by the view, workers and the main loop report. */
+  gint ref_count;
+  /** Lock for cond. */
+  GMutex mutex;
+  /** Signalled when the last chunk is done, or a chunk of a cancelled pass. */
+  GCond cond;
+} filter_job;
+
+/**
+ * Thread state for workers started for the view.
+ */
+typedef struct _thread_state_view {
+  /** Generic thread state. */
+  thread_state st;
+  /** The filter pass to help with. */
+  filter_job *job;
 } thread_state_view;
 /**
  * @param data A thread_state object.
@@ -748,39 +1585,151 @@ static void rofi_view_call_thread(gpointer data, gpointer user_data) {
   t->callback(t, user_data);
 }
 
-static void filter_elements(thread_state *ts,
-                            G_GNUC_UNUSED gpointer user_data) {
-  thread_state_view *t = (thread_state_view *)ts;
-  for (unsigned int i = t->start; i < t->stop; i++) {
-    int match = mode_token_match(t->state->sw, t->state->tokens, i);
+/**
+ * @param job The filter pass.
+ *
+ * Drop a reference, the last one frees the job.
+ */
+static void filter_job_unref(filter_job *job) {
+  if (g_atomic_int_dec_and_test(&(job->ref_count))) {
+    g_mutex_clear(&(job->mutex));
+    g_cond_clear(&(job->cond));
+    if (job->tokens) {
+      helper_tokenize_free(job->tokens);
+    }
+    levenshtein_needle_free(job->lev_needle);
+    g_free(job->input);
+    g_free(job->pattern);
+    g_free(job->candidate_map);
+    g_free(job->line_map);
+    g_free(job->distance);
+    g_free(job->chunk_count);
+    g_free(job);
+  }
+}
+
+/**
+ * @param job The filter pass.
+ * @param start First (candidate) row of the chunk.
+ * @param stop End of the chunk.
+ *
+ * Filter one chunk, matching rows are stored from start on in the line_map of
+ * the job.
+ *
+ * @returns the number of matching rows.
+ */
+static unsigned int filter_chunk(filter_job *job, unsigned int start,
+                                 unsigned int stop) {
+  unsigned int count = 0;
+  for (unsigned int k = start; k < stop; k++) {
+    // When narrowing, the candidates are the previous result.
+    unsigned int i =
+        job->candidate_map ? job->candidate_map[k] : job->first_row + k;
+    int match =
+        job->use_columns
+            ? helper_token_match_columns(job->tokens, &(job->columns), i)
+            : mode_token_match(job->sw, job->tokens, i);
     // If each token was matched, add it to list.
     if (match) {
-      t->state->line_map[t->start + t->count] = i;
-      if (config.sort) {
-        // This is inefficient, need to fix it.
-        char *str = mode_get_completion(t->state->sw, i);
-        glong slen = g_utf8_strlen(str, -1);
-        switch (config.sorting_method_enum) {
-        case SORT_FZF:
-          t->state->distance[i] =
-              rofi_scorer_fuzzy_evaluate(t->pattern, t->plen, str, slen);
+      job->line_map[start + count] = i;
+      if (job->sort) {
+        const ModeColumn *completion = &(job->columns.completion);
+        char *tmp = NULL;
+        const char *str;
+        gssize len = -1;
+        if (job->use_columns && completion->strings != NULL &&
+            completion->strings[i] != NULL) {
+          str = completion->strings[i];
+          len = completion->lengths[i];
+        } else if ((str = mode_peek_completion(job->sw, i)) == NULL) {
+          str = tmp = mode_get_completion(job->sw, i);
+        }
+        switch (job->sorting_method) {
+        case SORT_FZF: {
+          glong slen = g_utf8_strlen(str, len);
+          job->distance[i - job->first_row] =
+              rofi_scorer_fuzzy_evaluate(job->pattern, job->plen, str, slen);
           break;
+        }
         case SORT_NORMAL:
-        default:
-          t->state->distance[i] = levenshtein(t->pattern, t->plen, str, slen);
+        default: {
+          // The haystack length is in characters, len in bytes.
+          glong slen = (len < 0) ? -1 : g_utf8_strlen(str, len);
+          job->distance[i - job->first_row] =
+              levenshtein_needle_distance(job->lev_needle, str, slen, UINT_MAX);
           break;
         }
-        g_free(str);
+        }
+        g_free(tmp);
       }
-      t->count++;
+      count++;
     }
   }
-  if (t->acount != NULL) {
-    g_mutex_lock(t->mutex);
-    (*(t->acount))--;
-    g_cond_signal(t->cond);
-    g_mutex_unlock(t->mutex);
+  return count;
+}
+
+/**
+ * @param job The filter pass.
+ * @param deadline Monotonic time to stop taking chunks, 0 for no limit.
+ *
+ * Take and filter chunks until none are left. The one finishing the last
+ * chunk of a pass nobody waits for reports it to the main loop.
+ */
+static void filter_job_run(filter_job *job, gint64 deadline) {
+  unsigned int c;
+  TRACE_BEGIN("Filter rows");
+  while ((deadline == 0 || g_get_monotonic_time() < deadline) &&
+         (c = (unsigned int)g_atomic_int_add(&(job->cursor), 1)) <
+             job->num_chunks) {
+    unsigned int start = c * FILTER_CHUNK_SIZE;
+    unsigned int stop = MIN(job->candidates, start + FILTER_CHUNK_SIZE);
+    job->chunk_count[c] = filter_chunk(job, start, stop);
+    if ((unsigned int)g_atomic_int_add(&(job->done), 1) + 1 ==
+        job->num_chunks) {
+      g_mutex_lock(&(job->mutex));
+      if (job->background) {
+        g_atomic_int_inc(&(job->ref_count));
+        g_idle_add_full(G_PRIORITY_HIGH_IDLE, filter_job_done_idle, job, NULL);
+      }
+      g_cond_signal(&(job->cond));
+      g_mutex_unlock(&(job->mutex));
+    } else if (g_atomic_int_get(&(job->cancelled)) ||
+               g_atomic_int_get(&(job->paused))) {
+      // The canceller (or pauser) waits for the chunks in progress.
+      g_mutex_lock(&(job->mutex));
+      g_cond_signal(&(job->cond));
+      g_mutex_unlock(&(job->mutex));
+    }
   }
+  TRACE_END("Filter rows");
+}
+
+static void filter_elements_free(void *data) {
+  thread_state_view *t = (thread_state_view *)data;
+  filter_job_unref(t->job);
+  g_free(t);
+}
+
+static void filter_elements(thread_state *ts,
+                            G_GNUC_UNUSED gpointer user_data) {
+  thread_state_view *t = (thread_state_view *)ts;
+  filter_job_run(t->job, 0);
+  filter_elements_free(t);
+}
+
+/**
+ * @param job The filter pass.
+ *
+ * Push a worker for the pass to the thread pool.
+ */
+static void filter_job_push_helper(filter_job *job) {
+  thread_state_view *t = g_malloc0(sizeof(thread_state_view));
+  g_atomic_int_inc(&(job->ref_count));
+  t->job = job;
+  t->st.callback = filter_elements;
+  t->st.free = filter_elements_free;
+  t->st.priority = G_PRIORITY_HIGH;
+  g_thread_pool_push(tpool, t, NULL);
 }
 
 static void
@@ -1178,22 +2127,59 @@ void __create_window(MenuFlags menu_flags) {
   if (xcb->sncontext != NULL) {
     sn_launchee_context_setup_window(xcb->sncontext, CacheState.main_window);
   }
-  TICK_N("setup startup notification");
+  TICK_N("setup startup notification");
+  widget_free(WIDGET(win));
+  TICK_N("done");
+
+  // Set the PID.
+  pid_t pid = getpid();
+  xcb_ewmh_set_wm_pid(&(xcb->ewmh), CacheState.main_window, pid);
+
+  // Get hostname
+  const char *hostname = g_get_host_name();
+  char *ahost = g_hostname_to_ascii(hostname);
+  if (ahost != NULL) {
+    xcb_icccm_set_wm_client_machine(xcb->connection, CacheState.main_window,
+                                    XCB_ATOM_STRING, 8, strlen(ahost), ahost);
+    g_free(ahost);
+  }
+}
+
+void rofi_view_create_headless(MenuFlags menu_flags, int width, int height) {
+  // Without a window there is no input history to cycle through.
+  CacheState.entry_history_enable = FALSE;
+  CacheState.flags = menu_flags;
+  CacheState.mon.x = CacheState.mon.y = 0;
+  CacheState.mon.w = width;
+  CacheState.mon.h = height;
+  // Views draw on an in-memory surface, sized by
+  // rofi_view_window_update_size().
+  CacheState.edit_surf =
+      cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+  CacheState.edit_draw = cairo_create(CacheState.edit_surf);
+  PangoContext *p = pango_cairo_create_context(CacheState.edit_draw);
+  if (config.dpi > 1) {
+    PangoFontMap *font_map = pango_cairo_font_map_get_default();
+    pango_cairo_font_map_set_resolution((PangoCairoFontMap *)font_map,
+                                        (double)config.dpi);
+  }
+  box *win = box_create(NULL, "window", ROFI_ORIENTATION_HORIZONTAL);
+  const char *font =
+      rofi_theme_get_string(WIDGET(win), "font", config.menu_font);
+  if (font) {
+    PangoFontDescription *pfd = pango_font_description_from_string(font);
+    if (helper_validate_font(pfd, font)) {
+      pango_context_set_font_description(p, pfd);
+    }
+    pango_font_description_free(pfd);
+  }
+  pango_context_set_language(p, pango_language_get_default());
+  textbox_set_pango_context(font, p);
+  g_object_unref(p);
+  CacheState.fullscreen =
+      rofi_theme_get_boolean(WIDGET(win), "fullscreen", FALSE);
   widget_free(WIDGET(win));
-  TICK_N("done");
-
-  // Set the PID.
-  pid_t pid = getpid();
-  xcb_ewmh_set_wm_pid(&(xcb->ewmh), CacheState.main_window, pid);
-
-  // Get hostname
-  const char *hostname = g_get_host_name();
-  char *ahost = g_hostname_to_ascii(hostname);
-  if (ahost != NULL) {
-    xcb_icccm_set_wm_client_machine(xcb->connection, CacheState.main_window,
-                                    XCB_ATOM_STRING, 8, strlen(ahost), ahost);
-    g_free(ahost);
-  }
+  TICK_N("Headless view setup");
 }
 
 /**
@@ -1227,7 +2213,7 @@ static void rofi_view_nav_row_tab(RofiViewState *state) {
   if (state->filtered_lines == 1) {
     state->retv = MENU_OK;
     (state->selected_line) =
-        state->line_map[listview_get_selected(state->list_view)];
+        rofi_view_line(state, listview_get_selected(state->list_view));
     state->quit = 1;
     return;
   }
@@ -1254,7 +2240,7 @@ inline static void rofi_view_nav_row_select(RofiViewState *state) {
   unsigned int selected = listview_get_selected(state->list_view);
   // If a valid item is selected, return that..
   if (selected < state->filtered_lines) {
-    char *str = mode_get_completion(state->sw, state->line_map[selected]);
+    char *str = mode_get_completion(state->sw, rofi_view_line(state, selected));
     textbox_text(state->text, str);
     g_free(str);
     textbox_keybinding(state->text, MOVE_END);
@@ -1288,6 +2274,7 @@ inline static void rofi_view_nav_last(RofiViewState *state) {
 static void selection_changed_callback(G_GNUC_UNUSED listview *lv,
                                        unsigned int index, void *udata) {
   RofiViewState *state = (RofiViewState *)udata;
+  rofi_view_rank_lines(state, index + 1);
   if (state->tb_current_entry) {
     if (index < state->filtered_lines) {
       int fstate = 0;
@@ -1316,6 +2303,7 @@ static void selection_changed_callback(G_GNUC_UNUSED listview *lv,
 static void update_callback(textbox *t, icon *ico, unsigned int index,
                             void *udata, TextBoxFontType *type, gboolean full) {
   RofiViewState *state = (RofiViewState *)udata;
+  rofi_view_rank_lines(state, index + 1);
   if (full) {
     GList *add_list = NULL;
     int fstate = 0;
@@ -1345,8 +2333,9 @@ static void update_callback(textbox *t, icon *ico, unsigned int index,
         RofiHighlightColorStyle th = {ROFI_HL_BOLD | ROFI_HL_UNDERLINE,
                                       {0.0, 0.0, 0.0, 0.0}};
         th = rofi_theme_get_highlight(WIDGET(t), "highlight", th);
-        helper_token_match_get_pango_attr(th, state->tokens,
-                                          textbox_get_visible_text(t), list);
+        const GArray *spans = rofi_view_highlight_spans(
+            state, state->line_map[index], textbox_get_visible_text(t));
+        helper_token_match_spans_to_pango_attr(th, spans, list);
       }
       for (GList *iter = g_list_first(add_list); iter != NULL;
            iter = g_list_next(iter)) {
@@ -1371,6 +2360,10 @@ static void update_callback(textbox *t, icon *ico, unsigned int index,
 static void page_changed_callback() {
   rofi_view_workers_finalize();
   rofi_view_workers_initialize();
+  // Queued helpers got dropped, keep a filter pass in the background going.
+  if (current_active_menu && current_active_menu->filter_job) {
+    filter_job_push_helper(current_active_menu->filter_job);
+  }
 }
 
 void rofi_view_update(RofiViewState *state, gboolean qr) {
@@ -1379,6 +2372,8 @@ void rofi_view_update(RofiViewState *state, gboolean qr) {
   }
   g_debug("Redraw view");
   TICK();
+  TRACE_BEGIN("Draw");
+  gint64 start = Replay.input != 0 ? g_get_monotonic_time() : 0;
   cairo_t *d = CacheState.edit_draw;
   cairo_set_operator(d, CAIRO_OPERATOR_SOURCE);
   if (CacheState.fake_bg != NULL) {
@@ -1410,121 +2405,71 @@ void rofi_view_update(RofiViewState *state, gboolean qr) {
 
   TICK_N("widgets");
   cairo_surface_flush(CacheState.edit_surf);
+  if (start != 0) {
+    Replay.update += g_get_monotonic_time() - start;
+  }
+  TRACE_END("Draw");
   if (qr) {
     rofi_view_queue_redraw();
   }
 }
 
+/**
+ * @param state The Menu Handle
+ *
+ * Start timing a new filter pass, see RofiViewState::filter_timings.
+ */
+static void rofi_view_filter_timings_start(RofiViewState *state) {
+  memset(&(state->filter_timings), 0, sizeof(state->filter_timings));
+  state->filter_timings.start = g_get_monotonic_time();
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * The rows of the filter pass are matched, its result gets applied.
+ */
+static void rofi_view_filter_timings_filtered(RofiViewState *state) {
+  state->filter_timings.filter =
+      g_get_monotonic_time() - state->filter_timings.start;
+}
+
 static void _rofi_view_reload_row(RofiViewState *state) {
-  g_free(state->line_map);
-  g_free(state->distance);
+  // Rows changed, the previous result can no longer be narrowed.
+  rofi_view_prev_filter_clear(state);
+  rofi_view_filter_cache_clear(state);
   state->num_lines = mode_get_num_entries(state->sw);
-  state->line_map = g_malloc0_n(state->num_lines, sizeof(unsigned int));
-  state->distance = g_malloc0_n(state->num_lines, sizeof(int));
+  // The previous result is shown until the new pass is applied, that can
+  // take a while in the background. Drop the rows that went away.
+  unsigned int j = 0;
+  unsigned int ranked = 0;
+  for (unsigned int i = 0; i < state->filtered_lines; i++) {
+    if (state->line_map[i] < state->num_lines) {
+      state->line_map[j++] = state->line_map[i];
+      ranked += (i < state->ranked_lines) ? 1 : 0;
+    }
+  }
+  state->filtered_lines = j;
+  state->ranked_lines = ranked;
+  state->line_map = g_realloc_n(state->line_map, MAX(1, state->num_lines),
+                                sizeof(unsigned int));
+  state->distance =
+      g_realloc_n(state->distance, MAX(1, state->num_lines), sizeof(int));
   listview_set_max_lines(state->list_view, state->num_lines);
+  listview_set_num_elements(state->list_view, state->filtered_lines);
   rofi_view_reload_message_bar(state);
 }
 
-static gboolean rofi_view_refilter_real(RofiViewState *state) {
-  CacheState.refilter_timeout = 0;
-  CacheState.refilter_timeout_count = 0;
-  if (state->sw == NULL) {
-    return G_SOURCE_REMOVE;
-  }
-  GTimer *timer = g_timer_new();
-  TICK_N("Filter start");
-  if (state->reload) {
-    _rofi_view_reload_row(state);
-    state->reload = FALSE;
-  }
-  TICK_N("Filter reload rows");
-  if (state->tokens) {
-    helper_tokenize_free(state->tokens);
-    state->tokens = NULL;
-  }
-  TICK_N("Filter tokenize");
-  if (state->text && strlen(state->text->text) > 0) {
-
-    listview_set_filtered(state->list_view, TRUE);
-    unsigned int j = 0;
-    gchar *pattern = mode_preprocess_input(state->sw, state->text->text);
-    glong plen = pattern ? g_utf8_strlen(pattern, -1) : 0;
-    state->tokens = helper_tokenize(pattern, config.case_sensitive);
-    /**
-     * On long lists it can be beneficial to parallelize.
-     * If number of threads is 1, no thread is spawn.
-     * If number of threads > 1 and there are enough (> 1000) items, spawn jobs
-     * for the thread pool. For large lists with 8 threads I see a factor three
-     * speedup of the whole function.
-     */
-    unsigned int nt = MAX(1, state->num_lines / 500);
-    // Limit the number of jobs, it could cause stack overflow if we don´t
-    // limit.
-    nt = MIN(nt, config.threads * 4);
-    thread_state_view states[nt];
-    GCond cond;
-    GMutex mutex;
-    g_mutex_init(&mutex);
-    g_cond_init(&cond);
-    unsigned int count = nt;
-    unsigned int steps = (state->num_lines + nt) / nt;
-    for (unsigned int i = 0; i < nt; i++) {
-      states[i].state = state;
-      states[i].start = i * steps;
-      states[i].stop = MIN(state->num_lines, (i + 1) * steps);
-      states[i].count = 0;
-      states[i].cond = &cond;
-      states[i].mutex = &mutex;
-      states[i].acount = &count;
-      states[i].plen = plen;
-      states[i].pattern = pattern;
-      states[i].st.callback = filter_elements;
-      states[i].st.free = NULL;
-      states[i].st.priority = G_PRIORITY_HIGH;
-      if (i > 0) {
-        g_thread_pool_push(tpool, &states[i], NULL);
-      }
-    }
-    // Run one in this thread.
-    rofi_view_call_thread(&states[0], NULL);
-    // No need to do this with only one thread.
-    if (nt > 1) {
-      g_mutex_lock(&mutex);
-      while (count > 0) {
-        g_cond_wait(&cond, &mutex);
-      }
-      g_mutex_unlock(&mutex);
-    }
-    g_cond_clear(&cond);
-    g_mutex_clear(&mutex);
-    for (unsigned int i = 0; i < nt; i++) {
-      if (j != states[i].start) {
-        memmove(&(state->line_map[j]), &(state->line_map[states[i].start]),
-                sizeof(unsigned int) * (states[i].count));
-      }
-      j += states[i].count;
-    }
-    if (config.sort) {
-      g_qsort_with_data(state->line_map, j, sizeof(int), lev_sort,
-                        state->distance);
-    }
-
-    // Cleanup + bookkeeping.
-    state->filtered_lines = j;
-    g_free(pattern);
-
-    double elapsed = g_timer_elapsed(timer, NULL);
-
-    CacheState.max_refilter_time = elapsed;
-  } else {
-    listview_set_filtered(state->list_view, FALSE);
-    for (unsigned int i = 0; i < state->num_lines; i++) {
-      state->line_map[i] = i;
-    }
-    state->filtered_lines = state->num_lines;
-  }
+/**
+ * @param state The Menu Handle
+ *
+ * Update the widgets and window size after the filter result changed.
+ */
+static void rofi_view_refilter_done(RofiViewState *state) {
   TICK_N("Filter matching done");
+  gint64 now = g_get_monotonic_time();
   listview_set_num_elements(state->list_view, state->filtered_lines);
+  state->filter_timings.listview = g_get_monotonic_time() - now;
 
   if (state->tb_filtered_rows) {
     char *r = g_strdup_printf("%u", state->filtered_lines);
@@ -1541,12 +2486,13 @@ static gboolean rofi_view_refilter_real(RofiViewState *state) {
   if (config.auto_select == TRUE && state->filtered_lines == 1 &&
       state->num_lines > 1) {
     (state->selected_line) =
-        state->line_map[listview_get_selected(state->list_view)];
+        rofi_view_line(state, listview_get_selected(state->list_view));
     state->retv = MENU_OK;
     state->quit = TRUE;
   }
 
   // Size the window.
+  now = g_get_monotonic_time();
   int height = rofi_view_calculate_height(state);
   if (height != state->height) {
     state->height = height;
@@ -1554,51 +2500,553 @@ static gboolean rofi_view_refilter_real(RofiViewState *state) {
     rofi_view_window_update_size(state);
     g_debug("Resize based on re-filter");
   }
+  state->filter_timings.resize = g_get_monotonic_time() - now;
   TICK_N("Filter resize window based on window ");
-  state->refilter = FALSE;
   TICK_N("Filter done");
   rofi_view_update(state, TRUE);
+}
+
+/**
+ * @param state The Menu Handle
+ * @param sort If the result is sorted.
+ *
+ * Order the start of a new result, so it can be shown.
+ */
+static void rofi_view_filter_rank(RofiViewState *state, unsigned int sort) {
+  gint64 now = g_get_monotonic_time();
+  if (sort) {
+    // Only order what is shown, the rest is ordered when needed.
+    state->ranked_lines = 0;
+    rofi_view_rank_lines(state,
+                         listview_get_selected(state->list_view) +
+                             2 * listview_get_max_elements(state->list_view));
+  } else {
+    state->ranked_lines = state->filtered_lines;
+  }
+  state->filter_timings.sort = g_get_monotonic_time() - now;
+}
+
+/**
+ * @param job The completed filter pass.
+ *
+ * Compact the per chunk results to the start of line_map.
+ *
+ * @returns the number of matching rows.
+ */
+static unsigned int filter_job_compact(filter_job *job) {
+  unsigned int j = 0;
+  for (unsigned int c = 0; c < job->num_chunks; c++) {
+    unsigned int start = c * FILTER_CHUNK_SIZE;
+    if (j != start) {
+      memmove(&(job->line_map[j]), &(job->line_map[start]),
+              sizeof(unsigned int) * (job->chunk_count[c]));
+    }
+    j += job->chunk_count[c];
+  }
+  return j;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param job The completed filter pass over appended rows.
+ *
+ * Add the result of the pass to the current result, the query did not
+ * change.
+ */
+static void rofi_view_filter_apply_appended(RofiViewState *state,
+                                            filter_job *job) {
+  unsigned int j = filter_job_compact(job);
+  if (job->sort) {
+    for (unsigned int k = 0; k < j; k++) {
+      unsigned int row = job->line_map[k];
+      state->distance[row] = job->distance[row - job->first_row];
+    }
+  }
+  gint64 now = g_get_monotonic_time();
+  rofi_view_filter_add_rows(state, job->line_map, j, job->sort);
+  state->filter_timings.sort = g_get_monotonic_time() - now;
+  TICK_N("Filter appended rows");
+  rofi_view_refilter_done(state);
+}
+
+/**
+ * @param state The Menu Handle
+ * @param job The completed filter pass.
+ *
+ * Make the result of the filter pass the current result of the view.
+ */
+static void rofi_view_filter_apply(RofiViewState *state, filter_job *job) {
+  // A pending report of this pass to the main loop is now moot.
+  g_atomic_int_set(&(job->cancelled), TRUE);
+  rofi_view_filter_timings_filtered(state);
+  if (job->first_row > 0) {
+    rofi_view_filter_apply_appended(state, job);
+    return;
+  }
+  listview_set_filtered(state->list_view, TRUE);
+  unsigned int j = filter_job_compact(job);
+  g_free(state->line_map);
+  state->line_map = job->line_map;
+  job->line_map = NULL;
+  if (job->sort) {
+    g_free(state->distance);
+    state->distance = job->distance;
+    job->distance = NULL;
+  }
+  rofi_view_set_tokens(state, job->tokens);
+  job->tokens = NULL;
+  // Cleanup + bookkeeping.
+  state->filtered_lines = j;
+  FilterCacheEntry query = {.sw = job->sw,
+                            .pattern = job->pattern,
+                            .case_sensitive = job->case_sensitive,
+                            .matching_method = job->matching_method,
+                            .sort = job->sort,
+                            .sorting_method = job->sorting_method};
+  rofi_view_filter_cache_store(state, &query);
+  rofi_view_filter_rank(state, job->sort);
+  rofi_view_prev_filter_set(state, job->input, job->pattern,
+                            job->case_sensitive, job->sort,
+                            job->matching_method);
+  job->input = NULL;
+  job->pattern = NULL;
+  TICK_N(job->candidate_map ? "Filter candidate rows" : "Filter all rows");
+  rofi_view_refilter_done(state);
+}
 
-  g_timer_destroy(timer);
+/**
+ * @param state The Menu Handle
+ * @param input The raw user input.
+ * @param pattern The preprocessed user input.
+ *
+ * Show the cached result of an earlier pass with the same query, if any.
+ *
+ * @returns TRUE if the cached result is shown.
+ */
+static gboolean rofi_view_filter_cache_apply(RofiViewState *state,
+                                             const char *input,
+                                             const char *pattern) {
+  FilterCacheEntry query = {.sw = state->sw,
+                            .pattern = (char *)pattern,
+                            .case_sensitive = config.case_sensitive,
+                            .matching_method = config.matching_method,
+                            .sort = config.sort,
+                            .sorting_method = config.sorting_method_enum};
+  GList *link = rofi_view_filter_cache_find(state, &query);
+  if (link == NULL) {
+    return FALSE;
+  }
+  rofi_view_filter_timings_filtered(state);
+  FilterCacheEntry *entry = link->data;
+  g_queue_unlink(&(state->filter_cache), link);
+  g_queue_push_head_link(&(state->filter_cache), link);
+
+  listview_set_filtered(state->list_view, TRUE);
+  memcpy(state->line_map, entry->line_map,
+         sizeof(unsigned int) * entry->filtered_lines);
+  if (entry->sort) {
+    for (unsigned int i = 0; i < entry->filtered_lines; i++) {
+      state->distance[entry->line_map[i]] = entry->distance[i];
+    }
+  }
+  rofi_view_set_tokens(state,
+                       helper_tokenize(pattern, entry->case_sensitive));
+  state->filtered_lines = entry->filtered_lines;
+  rofi_view_filter_rank(state, entry->sort);
+  rofi_view_prev_filter_set(state, g_strdup(input), g_strdup(pattern),
+                            entry->case_sensitive, entry->sort,
+                            entry->matching_method);
+  TICK_N("Filter result from cache");
+  rofi_view_refilter_done(state);
+  return TRUE;
+}
+
+/**
+ * @param data The filter pass that completed in the background.
+ *
+ * Show the result of a filter pass that completed in the background, unless
+ * a newer pass replaced it in the mean time.
+ *
+ * @returns G_SOURCE_REMOVE
+ */
+static gboolean filter_job_done_idle(gpointer data) {
+  filter_job *job = (filter_job *)data;
+  // When cancelled, the view might be gone.
+  if (!g_atomic_int_get(&(job->cancelled)) &&
+      job->generation == job->state->filter_generation) {
+    RofiViewState *state = job->state;
+    g_debug("Filter pass %u completed in the background.", job->generation);
+    state->filter_job = NULL;
+    rofi_view_filter_apply(state, job);
+    // Reference of the view.
+    filter_job_unref(job);
+    if (state->append && !state->refilter) {
+      // Rows were appended while the pass ran, see
+      // rofi_view_refilter_appended().
+      rofi_view_refilter_appended(state);
+    }
+  }
+  filter_job_unref(job);
   return G_SOURCE_REMOVE;
 }
-static void rofi_view_refilter(RofiViewState *state) {
-  CacheState.refilter_timeout_count++;
-  if (CacheState.refilter_timeout != 0) {
-
-    g_source_remove(CacheState.refilter_timeout);
-    CacheState.refilter_timeout = 0;
-  }
-  if (CacheState.max_refilter_time > (config.refilter_timeout_limit / 1000.0) &&
-      state->text && strlen(state->text->text) > 0 &&
-      CacheState.refilter_timeout_count < 25) {
-    if (CacheState.delayed_mode == FALSE) {
-      g_warning(
-          "Filtering took %f seconds ( %f ), switching to delayed filter\n",
-          CacheState.max_refilter_time, config.refilter_timeout_limit / 1000.0);
-      CacheState.delayed_mode = TRUE;
-    }
-    CacheState.refilter_timeout =
-        g_timeout_add(200, (GSourceFunc)rofi_view_refilter_real, state);
+
+/**
+ * @param state The Menu Handle
+ *
+ * Drop the filter pass running in the background, if any. Chunks already in
+ * progress are waited for, after this no worker uses the mode anymore.
+ */
+static void filter_job_cancel(RofiViewState *state) {
+  filter_job *job = state->filter_job;
+  if (job == NULL) {
+    return;
+  }
+  state->filter_job = NULL;
+  g_atomic_int_set(&(job->cancelled), TRUE);
+  // Take all chunks nobody started on.
+  unsigned int started =
+      (unsigned int)g_atomic_int_add(&(job->cursor), job->num_chunks);
+  started = MIN(started, job->num_chunks);
+  g_mutex_lock(&(job->mutex));
+  while ((unsigned int)g_atomic_int_get(&(job->done)) < started) {
+    g_cond_wait(&(job->cond), &(job->mutex));
+  }
+  g_mutex_unlock(&(job->mutex));
+  g_debug("Filter pass %u cancelled.", job->generation);
+  if (job->first_row > 0) {
+    // The current result lacks the appended rows, it can not be narrowed.
+    rofi_view_prev_filter_clear(state);
+  }
+  filter_job_unref(job);
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Complete the filter pass running in the background, if any, in this thread
+ * and show its result.
+ */
+static void filter_job_finish(RofiViewState *state) {
+  filter_job *job = state->filter_job;
+  if (job == NULL) {
+    return;
+  }
+  filter_job_run(job, 0);
+  g_mutex_lock(&(job->mutex));
+  while ((unsigned int)g_atomic_int_get(&(job->done)) < job->num_chunks) {
+    g_cond_wait(&(job->cond), &(job->mutex));
+  }
+  g_mutex_unlock(&(job->mutex));
+  state->filter_job = NULL;
+  rofi_view_filter_apply(state, job);
+  filter_job_unref(job);
+}
+
+void rofi_view_filter_finish(void) {
+  if (current_active_menu) {
+    filter_job_finish(current_active_menu);
+  }
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Stop handing out chunks of the filter pass running in the background, if
+ * any, and wait for the chunks in progress. The pass continues with
+ * filter_job_resume().
+ */
+static void filter_job_pause(RofiViewState *state) {
+  filter_job *job = state->filter_job;
+  if (job == NULL || g_atomic_int_get(&(job->paused))) {
+    return;
+  }
+  g_atomic_int_set(&(job->paused), TRUE);
+  // Take all chunks nobody started on, like filter_job_cancel().
+  unsigned int started =
+      (unsigned int)g_atomic_int_add(&(job->cursor), job->num_chunks);
+  job->paused_cursor = MIN(started, job->num_chunks);
+  g_mutex_lock(&(job->mutex));
+  while ((unsigned int)g_atomic_int_get(&(job->done)) < job->paused_cursor) {
+    g_cond_wait(&(job->cond), &(job->mutex));
+  }
+  g_mutex_unlock(&(job->mutex));
+  g_debug("Filter pass %u paused.", job->generation);
+}
+
+/**
+ * @param state The Menu Handle
+ *
+ * Hand out the remaining chunks of the filter pass paused with
+ * filter_job_pause() again.
+ */
+static void filter_job_resume(RofiViewState *state) {
+  filter_job *job = state->filter_job;
+  if (job == NULL || !g_atomic_int_get(&(job->paused))) {
+    return;
+  }
+  g_atomic_int_set(&(job->cursor), job->paused_cursor);
+  g_atomic_int_set(&(job->paused), FALSE);
+  if (job->paused_cursor < job->num_chunks) {
+    // The workers left when they found no chunk to take.
+    unsigned int rows =
+        (job->num_chunks - job->paused_cursor) * FILTER_CHUNK_SIZE;
+    unsigned int helpers =
+        MIN(rows / MAX(1, config.filter_rows_per_thread), config.threads);
+    for (unsigned int i = 0; i < MAX(1, helpers); i++) {
+      filter_job_push_helper(job);
+    }
+  }
+  g_debug("Filter pass %u resumed.", job->generation);
+}
+
+void rofi_view_filter_pause(void) {
+  if (current_active_menu) {
+    filter_job_pause(current_active_menu);
+  }
+}
+
+void rofi_view_filter_resume(void) {
+  if (current_active_menu) {
+    filter_job_resume(current_active_menu);
+  }
+}
+
+/**
+ * @param state The Menu Handle
+ * @param input The raw user input, taken over.
+ * @param pattern The preprocessed user input, taken over.
+ * @param first_row First row to filter, the result of the rows before it is
+ * kept.
+ *
+ * Create a filter pass for the rows from first_row on with the current
+ * settings. The caller sets the candidates.
+ *
+ * @returns the new filter pass.
+ */
+static filter_job *rofi_view_filter_job_new(RofiViewState *state, char *input,
+                                            char *pattern,
+                                            unsigned int first_row) {
+  filter_job *job = g_malloc0(sizeof(filter_job));
+  job->state = state;
+  job->generation = ++(state->filter_generation);
+  job->sw = state->sw;
+  job->input = input;
+  job->pattern = pattern;
+  job->plen = job->pattern ? g_utf8_strlen(job->pattern, -1) : 0;
+  job->tokens = helper_tokenize(job->pattern, config.case_sensitive);
+  job->case_sensitive = config.case_sensitive;
+  job->matching_method = config.matching_method;
+  TICK_N("Filter tokenize");
+  // The exported columns are not normalized.
+  job->use_columns = !config.normalize_match &&
+                     mode_get_columns(state->sw, &(job->columns)) &&
+                     job->columns.num_rows >= state->num_lines;
+  TICK_N("Filter columns");
+  job->sort = config.sort;
+  job->sorting_method = config.sorting_method_enum;
+  if (job->sort && job->sorting_method != SORT_FZF) {
+    job->lev_needle = levenshtein_needle_new(job->pattern, job->plen);
+  }
+  job->num_lines = state->num_lines;
+  job->first_row = first_row;
+  unsigned int rows = job->num_lines - first_row;
+  job->line_map = g_malloc_n(MAX(1, rows), sizeof(unsigned int));
+  if (job->sort) {
+    job->distance = g_malloc_n(MAX(1, rows), sizeof(int));
+  }
+  return job;
+}
+
+/**
+ * @param state The Menu Handle
+ * @param job The filter pass, the view takes the reference.
+ * @param wait Wait for the result, instead of continuing in the background.
+ *
+ * Run the filter pass. Without wait, this thread helps until the pass is
+ * done or refilter-timeout-limit is up, after that the main loop continues
+ * and the result is shown once the workers are done.
+ */
+static void rofi_view_filter_job_start(RofiViewState *state, filter_job *job,
+                                       gboolean wait) {
+  job->num_chunks =
+      (job->candidates + FILTER_CHUNK_SIZE - 1) / FILTER_CHUNK_SIZE;
+  job->chunk_count =
+      g_malloc0_n(MAX(1, job->num_chunks), sizeof(unsigned int));
+  job->ref_count = 1;
+  g_mutex_init(&(job->mutex));
+  g_cond_init(&(job->cond));
+  state->filter_job = job;
+  /**
+   * On long lists it can be beneficial to parallelize.
+   * If number of threads is 1, no thread is spawn.
+   * Otherwise, helpers are pushed to the thread pool (one per
+   * filter-rows-per-thread rows, at most one less than the number of
+   * threads). They pull chunks until none are left, this thread does the
+   * same. Helpers that only get scheduled after all chunks are taken find no
+   * work; nobody waits for them.
+   */
+  unsigned int helpers = MIN(
+      job->candidates / MAX(1, config.filter_rows_per_thread), config.threads);
+  helpers = (helpers > 0) ? helpers - 1 : 0;
+  for (unsigned int i = 0; i < helpers; i++) {
+    filter_job_push_helper(job);
+  }
+  // Work in this thread too.
+  gint64 deadline = 0;
+  if (!wait) {
+    gint64 limit = config.refilter_timeout_limit;
+    deadline = g_get_monotonic_time() + limit * G_TIME_SPAN_MILLISECOND;
+  }
+  filter_job_run(job, deadline);
+  g_mutex_lock(&(job->mutex));
+  while ((unsigned int)g_atomic_int_get(&(job->done)) < job->num_chunks) {
+    if (deadline == 0) {
+      g_cond_wait(&(job->cond), &(job->mutex));
+    } else if (!g_cond_wait_until(&(job->cond), &(job->mutex), deadline)) {
+      break;
+    }
+  }
+  job->background =
+      (unsigned int)g_atomic_int_get(&(job->done)) < job->num_chunks;
+  g_mutex_unlock(&(job->mutex));
+  if (job->background) {
+    // Time is up, let the workers finish while the main loop continues.
+    if (helpers == 0) {
+      filter_job_push_helper(job);
+    }
+    g_debug("Filter pass %u continues in the background.", job->generation);
+    TICK_N("Filter continues in the background");
+    return;
+  }
+  state->filter_job = NULL;
+  rofi_view_filter_apply(state, job);
+  filter_job_unref(job);
+}
+
+/**
+ * @param state The Menu Handle
+ * @param wait Wait for the result, instead of continuing in the background.
+ *
+ * Start a new filter pass for the current input, the pass in flight is
+ * cancelled.
+ */
+static void rofi_view_refilter_real(RofiViewState *state, gboolean wait) {
+  filter_job_cancel(state);
+  if (state->sw == NULL) {
+    return;
+  }
+  rofi_view_filter_timings_start(state);
+  TICK_N("Filter start");
+  if (state->reload || state->append) {
+    _rofi_view_reload_row(state);
+    state->reload = FALSE;
+    state->append = FALSE;
+  }
+  TICK_N("Filter reload rows");
+  state->refilter = FALSE;
+  if (state->text && strlen(state->text->text) > 0) {
+    char *pattern = mode_preprocess_input(state->sw, state->text->text);
+    if (rofi_view_filter_cache_apply(state, state->text->text, pattern)) {
+      g_free(pattern);
+      return;
+    }
+    filter_job *job = rofi_view_filter_job_new(
+        state, g_strdup(state->text->text), pattern, 0);
+    // If the query got more specific, only the previous result can match.
+    if (rofi_view_prev_filter_can_narrow(state, job->input, job->pattern)) {
+      job->candidate_map = g_memdup2(
+          state->line_map, sizeof(unsigned int) * state->filtered_lines);
+      job->candidates = state->filtered_lines;
+    } else if (job->use_columns && job->columns.index != NULL &&
+               (job->candidate_map = helper_trigram_index_query(
+                    job->columns.index, job->tokens, state->num_lines,
+                    &(job->candidates))) != NULL) {
+      TICK_N("Filter trigram index");
+    } else {
+      job->candidates = state->num_lines;
+    }
+    rofi_view_filter_job_start(state, job, wait);
   } else {
-    if (CacheState.delayed_mode == TRUE && state->text &&
-        strlen(state->text->text) > 0 &&
-        CacheState.refilter_timeout_count < 25) {
-      g_warning(
-          "Filtering took %f seconds , switching back to instant filter\n",
-          CacheState.max_refilter_time);
-      CacheState.delayed_mode = FALSE;
+    listview_set_filtered(state->list_view, FALSE);
+    rofi_view_prev_filter_clear(state);
+    rofi_view_set_tokens(state, NULL);
+    for (unsigned int i = 0; i < state->num_lines; i++) {
+      state->line_map[i] = i;
     }
-    rofi_view_refilter_real(state);
+    state->filtered_lines = state->num_lines;
+    state->ranked_lines = state->num_lines;
+    rofi_view_filter_timings_filtered(state);
+    rofi_view_refilter_done(state);
   }
 }
-static void rofi_view_refilter_force(RofiViewState *state) {
-  if (CacheState.refilter_timeout != 0) {
-    g_source_remove(CacheState.refilter_timeout);
-    CacheState.refilter_timeout = 0;
+
+/**
+ * @param state The Menu Handle
+ *
+ * Rows were appended to the mode. Filter only the new rows with the current
+ * query and add them to the current result. If the result is not for the
+ * current input and settings, or rows went away, everything is filtered
+ * again. While a pass runs in the background, this waits for its result.
+ */
+static void rofi_view_refilter_appended(RofiViewState *state) {
+  if (state->filter_job != NULL) {
+    // The current result has to be complete to add to it. The pass picks up
+    // the appended rows once it is applied, see filter_job_done_idle().
+    return;
   }
-  if (state->refilter) {
-    rofi_view_refilter_real(state);
+  state->append = FALSE;
+  unsigned int first_row = state->num_lines;
+  unsigned int num_lines = mode_get_num_entries(state->sw);
+  gboolean filtered = state->text && strlen(state->text->text) > 0;
+  if (num_lines < first_row ||
+      (filtered &&
+       g_strcmp0(state->prev_filter.input, state->text->text) != 0)) {
+    state->reload = TRUE;
+    rofi_view_refilter_real(state, FALSE);
+    return;
+  }
+  if (num_lines == first_row) {
+    return;
+  }
+  rofi_view_filter_timings_start(state);
+  TICK_N("Filter append start");
+  // Cached results lack the new rows.
+  rofi_view_filter_cache_clear(state);
+  state->num_lines = num_lines;
+  state->line_map =
+      g_realloc_n(state->line_map, MAX(1, num_lines), sizeof(unsigned int));
+  state->distance =
+      g_realloc_n(state->distance, MAX(1, num_lines), sizeof(int));
+  listview_set_max_lines(state->list_view, state->num_lines);
+  rofi_view_reload_message_bar(state);
+  if (!filtered) {
+    for (unsigned int i = first_row; i < num_lines; i++) {
+      state->line_map[i] = i;
+    }
+    state->filtered_lines = num_lines;
+    state->ranked_lines = num_lines;
+    rofi_view_filter_timings_filtered(state);
+    rofi_view_refilter_done(state);
+    return;
+  }
+  filter_job *job =
+      rofi_view_filter_job_new(state, g_strdup(state->prev_filter.input),
+                               g_strdup(state->prev_filter.pattern), first_row);
+  job->candidates = num_lines - first_row;
+  rofi_view_filter_job_start(state, job, FALSE);
+}
+static void rofi_view_refilter(RofiViewState *state) {
+  TRACE_BEGIN("Refilter");
+  rofi_view_refilter_real(state, FALSE);
+  TRACE_END("Refilter");
+}
+static void rofi_view_refilter_force(RofiViewState *state) {
+  if (state->refilter || state->append) {
+    TRACE_BEGIN("Refilter");
+    rofi_view_refilter_real(state, TRUE);
+    TRACE_END("Refilter");
+  } else {
+    filter_job_finish(state);
   }
 }
 /**
@@ -1608,6 +3056,10 @@ static void rofi_view_refilter_force(RofiViewState *state) {
  */
 void process_result(RofiViewState *state);
 void rofi_view_finalize(RofiViewState *state) {
+  if (state) {
+    // The mode might change its rows.
+    filter_job_cancel(state);
+  }
   if (state && state->finalize != NULL) {
     state->finalize(state);
   }
@@ -1653,7 +3105,7 @@ static void rofi_view_trigger_global_action(KeyBindingAction action) {
     char *data = NULL;
     unsigned int selected = listview_get_selected(state->list_view);
     if (selected < state->filtered_lines) {
-      data = mode_get_completion(state->sw, state->line_map[selected]);
+      data = mode_get_completion(state->sw, rofi_view_line(state, selected));
     } else if (state->text && state->text->text) {
       data = g_strdup(state->text->text);
     }
@@ -1694,7 +3146,7 @@ static void rofi_view_trigger_global_action(KeyBindingAction action) {
     unsigned int selected = listview_get_selected(state->list_view);
     state->selected_line = UINT32_MAX;
     if (selected < state->filtered_lines) {
-      state->selected_line = state->line_map[selected];
+      state->selected_line = rofi_view_line(state, selected);
     }
     state->retv = MENU_COMPLETE;
     state->quit = TRUE;
@@ -1713,7 +3165,7 @@ static void rofi_view_trigger_global_action(KeyBindingAction action) {
   case DELETE_ENTRY: {
     unsigned int selected = listview_get_selected(state->list_view);
     if (selected < state->filtered_lines) {
-      (state->selected_line) = state->line_map[selected];
+      (state->selected_line) = rofi_view_line(state, selected);
       state->retv = MENU_ENTRY_DELETE;
       state->quit = TRUE;
     }
@@ -1731,7 +3183,7 @@ static void rofi_view_trigger_global_action(KeyBindingAction action) {
   case SELECT_ELEMENT_10: {
     unsigned int index = action - SELECT_ELEMENT_1;
     if (index < state->filtered_lines) {
-      state->selected_line = state->line_map[index];
+      state->selected_line = rofi_view_line(state, index);
       state->retv = MENU_OK;
       state->quit = TRUE;
     }
@@ -1759,7 +3211,7 @@ static void rofi_view_trigger_global_action(KeyBindingAction action) {
     state->selected_line = UINT32_MAX;
     unsigned int selected = listview_get_selected(state->list_view);
     if (selected < state->filtered_lines) {
-      (state->selected_line) = state->line_map[selected];
+      (state->selected_line) = rofi_view_line(state, selected);
     }
     state->retv = MENU_CUSTOM_COMMAND | ((action - CUSTOM_1) & MENU_LOWER_MASK);
     state->quit = TRUE;
@@ -1846,7 +3298,7 @@ static void rofi_view_trigger_global_action(KeyBindingAction action) {
     unsigned int selected = listview_get_selected(state->list_view);
     state->selected_line = UINT32_MAX;
     if (selected < state->filtered_lines) {
-      (state->selected_line) = state->line_map[selected];
+      (state->selected_line) = rofi_view_line(state, selected);
       state->retv = MENU_OK;
     } else {
       // Nothing entered and nothing selected.
@@ -1876,7 +3328,7 @@ static void rofi_view_trigger_global_action(KeyBindingAction action) {
     unsigned int selected = listview_get_selected(state->list_view);
     state->selected_line = UINT32_MAX;
     if (selected < state->filtered_lines) {
-      (state->selected_line) = state->line_map[selected];
+      (state->selected_line) = rofi_view_line(state, selected);
       state->retv = MENU_OK;
     } else {
       // Nothing entered and nothing selected.
@@ -2104,6 +3556,8 @@ void rofi_view_maybe_update(RofiViewState *state) {
   // Update if requested.
   if (state->refilter) {
     rofi_view_refilter(state);
+  } else if (state->append) {
+    rofi_view_refilter_appended(state);
   }
   rofi_view_update(state, TRUE);
   return;
@@ -2192,7 +3646,7 @@ WidgetTriggerActionResult textbox_button_trigger_action(
     if (type) {
       if (state->list_view) {
         (state->selected_line) =
-            state->line_map[listview_get_selected(state->list_view)];
+            rofi_view_line(state, listview_get_selected(state->list_view));
       } else {
         (state->selected_line) = UINT32_MAX;
       }
@@ -2247,7 +3701,7 @@ static void rofi_view_listview_mouse_activated_cb(listview *lv, gboolean custom,
   if (custom) {
     state->retv |= MENU_CUSTOM_ACTION;
   }
-  (state->selected_line) = state->line_map[listview_get_selected(lv)];
+  (state->selected_line) = rofi_view_line(state, listview_get_selected(lv));
   // Quit
   state->quit = TRUE;
   state->skip_absorb = TRUE;
@@ -2551,14 +4005,20 @@ RofiViewState *rofi_view_create(Mode *sw, const char *input,
   rofi_view_window_update_size(state);
 
   state->quit = FALSE;
-  rofi_view_refilter(state);
+  // Callers set the selection right after, the first result has to be there.
+  rofi_view_refilter_force(state);
   rofi_view_update(state, TRUE);
-  xcb_map_window(xcb->connection, CacheState.main_window);
   widget_queue_redraw(WIDGET(state->main_window));
+  rofi_view_set_user_timeout(NULL);
+  replay_start();
+  if (CacheState.main_window == XCB_WINDOW_NONE) {
+    // Headless, see rofi_view_create_headless().
+    return state;
+  }
+  xcb_map_window(xcb->connection, CacheState.main_window);
   rofi_view_ping_mouse(state);
   xcb_flush(xcb->connection);
 
-  rofi_view_set_user_timeout(NULL);
   /* When Override Redirect, the WM will not let us know we can take focus, so
    * just steal it */
   if (((menu_flags & MENU_NORMAL_WINDOW) == 0)) {
@@ -2622,6 +4082,8 @@ void rofi_view_hide(void) {
 }
 
 void rofi_view_cleanup(void) {
+  // Report the replay when the view was closed before the script ended.
+  replay_report();
   // Clear clipboard data.
   xcb_stuff_set_clipboard(NULL);
   g_debug("Cleanup.");
@@ -2629,10 +4091,6 @@ void rofi_view_cleanup(void) {
     g_source_remove(CacheState.idle_timeout);
     CacheState.idle_timeout = 0;
   }
-  if (CacheState.refilter_timeout > 0) {
-    g_source_remove(CacheState.refilter_timeout);
-    CacheState.refilter_timeout = 0;
-  }
   if (CacheState.user_timeout > 0) {
     g_source_remove(CacheState.user_timeout);
     CacheState.user_timeout = 0;
@@ -2763,6 +4221,7 @@ void rofi_view_ellipsize_listview(RofiViewState *state,
 }
 
 void rofi_view_switch_mode(RofiViewState *state, Mode *mode) {
+  filter_job_cancel(state);
   state->sw = mode;
   // Update prompt;
   if (state->prompt) {
@@ -2793,6 +4252,9 @@ void rofi_view_switch_mode(RofiViewState *state, Mode *mode) {
 xcb_window_t rofi_view_get_window(void) { return CacheState.main_window; }
 
 void rofi_view_set_window_title(const char *title) {
+  if (CacheState.main_window == XCB_WINDOW_NONE) {
+    return;
+  }
   ssize_t len = strlen(title);
   xcb_change_property(xcb->connection, XCB_PROP_MODE_REPLACE,
                       CacheState.main_window, xcb->ewmh._NET_WM_NAME,
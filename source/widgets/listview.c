@@ -1150,6 +1150,13 @@ void listview_set_mouse_activated_cb(listview *lv,
   }
 }
 
+unsigned int listview_get_max_elements(listview *lv) {
+  if (lv) {
+    return lv->max_elements;
+  }
+  return 0;
+}
+
 void listview_set_max_lines(listview *lv, unsigned int max_lines) {
   if (lv) {
     lv->max_displayed_lines = max_lines;
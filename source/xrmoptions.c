@@ -437,8 +437,14 @@ static XrmOption xrmOptions[] = {
      "refilter-timeout-limit",
      {.num = &(config.refilter_timeout_limit)},
      NULL,
-     "When filtering takes  more then this time (in ms) switch to delayed "
-     "filter.",
+     "When filtering takes more then this time (in ms), continue it in the "
+     "background.",
+     CONFIG_DEFAULT},
+    {xrm_Number,
+     "filter-rows-per-thread",
+     {.num = &(config.filter_rows_per_thread)},
+     NULL,
+     "Number of rows per thread used for filtering.",
      CONFIG_DEFAULT},
     {xrm_Boolean,
      "xserver-i300-workaround",
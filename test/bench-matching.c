@@ -0,0 +1,475 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Microbenchmarks of the matching and scoring kernels.
+ *
+ * Each kernel is run over synthetic corpora and over the (recorded) corpora
+ * passed as arguments, one row per line. The result of each run is printed as
+ * one JSON object per line:
+ *
+ * {"benchmark":"token_match","corpus":"paths","variant":"glob-ci",
+ *  "ops":123456,"ns_per_op":12.3,"allocs_per_op":0.00}
+ *
+ * allocs_per_op is -1 when allocations can not be counted. The minimum run
+ * time per benchmark (in seconds) can be set with ROFI_BENCH_MIN_TIME.
+ */
+
+#include "config.h"
+
+#include "display.h"
+#include "rofi-icon-fetcher.h"
+#include "rofi-types.h"
+#include "rofi.h"
+#include "settings.h"
+#include "theme.h"
+#include "widgets/textbox.h"
+#include "xcb-internal.h"
+#include "xcb.h"
+#include <glib.h>
+#include <helper.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ThemeWidget *rofi_theme = NULL;
+
+uint32_t rofi_icon_fetcher_query(G_GNUC_UNUSED const char *name,
+                                 G_GNUC_UNUSED const int size) {
+  return 0;
+}
+uint32_t rofi_icon_fetcher_query_advanced(G_GNUC_UNUSED const char *name,
+                                          G_GNUC_UNUSED const int wsize,
+                                          G_GNUC_UNUSED const int hsize) {
+  return 0;
+}
+void rofi_clear_error_messages(void) {}
+void rofi_clear_warning_messages(void) {}
+
+cairo_surface_t *rofi_icon_fetcher_get(G_GNUC_UNUSED const uint32_t uid) {
+  return NULL;
+}
+
+gboolean rofi_theme_parse_string(G_GNUC_UNUSED const char *string) {
+  return FALSE;
+}
+
+double textbox_get_estimated_char_height(void) { return 12.0; }
+void rofi_view_get_current_monitor(int *width, int *height) {
+  *width = 1920;
+  *height = 1080;
+}
+double textbox_get_estimated_ch(void) { return 9.0; }
+void rofi_add_error_message(G_GNUC_UNUSED GString *msg) {}
+void rofi_add_warning_message(G_GNUC_UNUSED GString *msg) {}
+int rofi_view_error_dialog(const char *msg, G_GNUC_UNUSED int markup) {
+  fputs(msg, stderr);
+  return TRUE;
+}
+int monitor_active(G_GNUC_UNUSED workarea *mon) { return 0; }
+
+void display_startup_notification(
+    G_GNUC_UNUSED RofiHelperExecuteContext *context,
+    G_GNUC_UNUSED GSpawnChildSetupFunc *child_setup,
+    G_GNUC_UNUSED gpointer *user_data) {}
+
+/**
+ * Allocation counting.
+ * With glibc, malloc and friends are wrapped to count the calls, including
+ * the ones made by glib.
+ */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define BENCH_COUNT_ALLOCS 1
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+/** Number of allocations since the start. */
+static gsize bench_allocs = 0;
+
+void *malloc(size_t size) {
+  bench_allocs++;
+  return __libc_malloc(size);
+}
+void *calloc(size_t nmemb, size_t size) {
+  bench_allocs++;
+  return __libc_calloc(nmemb, size);
+}
+void *realloc(void *ptr, size_t size) {
+  bench_allocs++;
+  return __libc_realloc(ptr, size);
+}
+void free(void *ptr) { __libc_free(ptr); }
+#endif
+
+/**
+ * A list of rows to run the kernels on.
+ */
+typedef struct {
+  /** Name of the corpus. */
+  char *name;
+  /** The rows. */
+  GPtrArray *rows;
+  /** The query typed by the user. */
+  const char *query;
+} BenchCorpus;
+
+/** Minimum run time of each benchmark in microseconds. */
+static gint64 bench_min_time = 200000;
+
+/** Accumulates results, so the compiler keeps the work. */
+static volatile gsize bench_sink = 0;
+
+/**
+ * Run and report one benchmark.
+ *
+ * @param benchmark Name of the kernel.
+ * @param corpus The corpus.
+ * @param variant Name of the variant (matching method, case sensitivity).
+ * @param kernel The kernel, called per row, returns a value for the sink.
+ * @param data User data for the kernel.
+ */
+static void bench_run(const char *benchmark, const BenchCorpus *corpus,
+                      const char *variant,
+                      gsize (*kernel)(const char *row, gpointer data),
+                      gpointer data) {
+  GPtrArray *rows = corpus->rows;
+  if (rows->len == 0) {
+    return;
+  }
+  // Warm up.
+  for (guint i = 0; i < rows->len; i++) {
+    bench_sink += kernel(g_ptr_array_index(rows, i), data);
+  }
+  guint64 ops = 0;
+#ifdef BENCH_COUNT_ALLOCS
+  gsize allocs = bench_allocs;
+#endif
+  gint64 start = g_get_monotonic_time();
+  gint64 elapsed = 0;
+  do {
+    for (guint i = 0; i < rows->len; i++) {
+      bench_sink += kernel(g_ptr_array_index(rows, i), data);
+    }
+    ops += rows->len;
+    elapsed = g_get_monotonic_time() - start;
+  } while (elapsed < bench_min_time);
+  double allocs_per_op = -1;
+#ifdef BENCH_COUNT_ALLOCS
+  allocs_per_op = (bench_allocs - allocs) / (double)ops;
+#endif
+  printf("{\"benchmark\":\"%s\",\"corpus\":\"%s\",\"variant\":\"%s\","
+         "\"ops\":%" G_GUINT64_FORMAT ",\"ns_per_op\":%.1f,"
+         "\"allocs_per_op\":%.2f}\n",
+         benchmark, corpus->name, variant, ops, elapsed * 1000.0 / ops,
+         allocs_per_op);
+  fflush(stdout);
+}
+
+static gsize kernel_tokenize(G_GNUC_UNUSED const char *row, gpointer data) {
+  rofi_int_matcher **tokens =
+      helper_tokenize((const char *)data, config.case_sensitive);
+  gsize retv = tokens != NULL;
+  helper_tokenize_free(tokens);
+  return retv;
+}
+
+static gsize kernel_token_match(const char *row, gpointer data) {
+  return helper_token_match((rofi_int_matcher **)data, row);
+}
+
+static gsize kernel_levenshtein(const char *row, gpointer data) {
+  const char *query = (const char *)data;
+  return levenshtein(query, g_utf8_strlen(query, -1), row,
+                     g_utf8_strlen(row, -1));
+}
+
+static gsize kernel_levenshtein_needle(const char *row, gpointer data) {
+  return levenshtein_needle_distance((const RofiLevenshteinNeedle *)data, row,
+                                     -1, UINT_MAX);
+}
+
+static gsize kernel_fzf(const char *row, gpointer data) {
+  const char *query = (const char *)data;
+  return (gsize)rofi_scorer_fuzzy_evaluate(query, g_utf8_strlen(query, -1),
+                                           row, g_utf8_strlen(row, -1));
+}
+
+static gsize kernel_force_utf8(const char *row,
+                               G_GNUC_UNUSED gpointer data) {
+  char *str = rofi_force_utf8(row, strlen(row));
+  gsize retv = str[0];
+  g_free(str);
+  return retv;
+}
+
+/** Matching methods to run, with the names used in the output. */
+static const struct {
+  MatchingMethod method;
+  const char *name;
+} bench_methods[] = {
+    {MM_NORMAL, "normal"}, {MM_REGEX, "regex"},   {MM_GLOB, "glob"},
+    {MM_FUZZY, "fuzzy"},   {MM_PREFIX, "prefix"},
+};
+
+/**
+ * @param corpus The corpus.
+ *
+ * Run all kernels on corpus.
+ */
+static void bench_corpus(const BenchCorpus *corpus) {
+  for (gsize m = 0; m < G_N_ELEMENTS(bench_methods); m++) {
+    config.matching_method = bench_methods[m].method;
+    for (int cs = 0; cs < 2; cs++) {
+      char *variant =
+          g_strdup_printf("%s-%s", bench_methods[m].name, cs ? "cs" : "ci");
+      config.case_sensitive = cs;
+      bench_run("tokenize", corpus, variant, kernel_tokenize,
+                (gpointer)corpus->query);
+      rofi_int_matcher **tokens = helper_tokenize(corpus->query, cs);
+      bench_run("token_match", corpus, variant, kernel_token_match, tokens);
+      helper_tokenize_free(tokens);
+      g_free(variant);
+    }
+    // Normalized matching, this simplifies each row before matching.
+    config.normalize_match = TRUE;
+    config.case_sensitive = FALSE;
+    rofi_int_matcher **tokens = helper_tokenize(corpus->query, FALSE);
+    char *variant = g_strdup_printf("%s-ci-normalize", bench_methods[m].name);
+    bench_run("token_match", corpus, variant, kernel_token_match, tokens);
+    g_free(variant);
+    helper_tokenize_free(tokens);
+    config.normalize_match = FALSE;
+  }
+  config.matching_method = MM_NORMAL;
+
+  // Sorting methods.
+  bench_run("levenshtein", corpus, "normal", kernel_levenshtein,
+            (gpointer)corpus->query);
+  RofiLevenshteinNeedle *needle =
+      levenshtein_needle_new(corpus->query, g_utf8_strlen(corpus->query, -1));
+  bench_run("levenshtein_needle", corpus, "normal", kernel_levenshtein_needle,
+            needle);
+  levenshtein_needle_free(needle);
+  bench_run("rofi_scorer_fuzzy_evaluate", corpus, "fzf", kernel_fzf,
+            (gpointer)corpus->query);
+
+  bench_run("rofi_force_utf8", corpus, "none", kernel_force_utf8, NULL);
+}
+
+/**
+ * @param rand Random generator.
+ * @param words The words to pick from.
+ * @param n Number of words.
+ *
+ * @returns a random word.
+ */
+static const char *bench_pick(GRand *rand, const char *const *words,
+                              gsize n) {
+  return words[g_rand_int_range(rand, 0, (gint32)n)];
+}
+
+/** Number of rows in each synthetic corpus. */
+#define BENCH_SYNTHETIC_ROWS 20000
+
+/**
+ * @param corpora Array to add the corpora to.
+ *
+ * Generate the synthetic corpora, with a fixed seed so runs compare.
+ */
+static void bench_synthetic_corpora(GPtrArray *corpora) {
+  static const char *const dirs[] = {
+      "usr",   "lib",     "share", "local",   "bin",     "include", "home",
+      "user",  "src",     "rofi",  "source",  "modes",   "build",   "doc",
+      "icons", "hicolor", "48x48", "apps",    "x86_64",  "python3", "site",
+      "etc",   "systemd", "var",   "log",     "cache",   "fonts",   "ttf"};
+  static const char *const exts[] = {".c", ".h", ".so.6", ".png", ".svg",
+                                     ".py", ".conf", ".desktop", ".txt"};
+  static const char *const hosts[] = {"web01", "db-primary", "cache3",
+                                      "gateway"};
+  static const char *const daemons[] = {"sshd", "systemd", "kernel", "cron",
+                                        "NetworkManager", "dbus-daemon"};
+  static const char *const messages[] = {
+      "Accepted publickey for user from 10.0.0.12 port 52814 ssh2",
+      "Started Session 42 of User root.",
+      "error: connection reset by peer",
+      "usb 1-2: new high-speed USB device number 7 using xhci_hcd",
+      "Failed password for invalid user admin from 192.168.1.20",
+      "device (wlp3s0): state change: activated -> deactivating",
+      "(root) CMD (run-parts /etc/cron.hourly)",
+      "Out of memory: Killed process 4242 (chromium)"};
+  static const char *const cjk[] = {"東京", "大阪", "日本語", "入力",
+                                    "文件",   "设置", "终端",   "浏览器",
+                                    "파일",   "설정", "ファイル", "テキスト"};
+  static const char *const latin[] = {"cafe",  "resume", "naive", "cliche",
+                                      "fiance", "facade", "uber",  "senor"};
+  GRand *rand = g_rand_new_with_seed(42);
+
+  BenchCorpus *paths = g_malloc0(sizeof(BenchCorpus));
+  paths->name = g_strdup("paths");
+  paths->query = "lib so";
+  paths->rows = g_ptr_array_new_with_free_func(g_free);
+  for (int i = 0; i < BENCH_SYNTHETIC_ROWS; i++) {
+    GString *str = g_string_new(NULL);
+    int levels = g_rand_int_range(rand, 2, 8);
+    for (int d = 0; d < levels; d++) {
+      g_string_append_printf(str, "/%s",
+                             bench_pick(rand, dirs, G_N_ELEMENTS(dirs)));
+    }
+    g_string_append_printf(str, "/file%d%s", i,
+                           bench_pick(rand, exts, G_N_ELEMENTS(exts)));
+    g_ptr_array_add(paths->rows, g_string_free(str, FALSE));
+  }
+  g_ptr_array_add(corpora, paths);
+
+  BenchCorpus *logs = g_malloc0(sizeof(BenchCorpus));
+  logs->name = g_strdup("logs");
+  logs->query = "error reset";
+  logs->rows = g_ptr_array_new_with_free_func(g_free);
+  for (int i = 0; i < BENCH_SYNTHETIC_ROWS; i++) {
+    g_ptr_array_add(
+        logs->rows,
+        g_strdup_printf("Oct %2d %02d:%02d:%02d %s %s[%d]: %s", 1 + i % 28,
+                        (i / 3600) % 24, (i / 60) % 60, i % 60,
+                        bench_pick(rand, hosts, G_N_ELEMENTS(hosts)),
+                        bench_pick(rand, daemons, G_N_ELEMENTS(daemons)),
+                        g_rand_int_range(rand, 1, 65536),
+                        bench_pick(rand, messages, G_N_ELEMENTS(messages))));
+  }
+  g_ptr_array_add(corpora, logs);
+
+  BenchCorpus *cjk_corpus = g_malloc0(sizeof(BenchCorpus));
+  cjk_corpus->name = g_strdup("cjk");
+  cjk_corpus->query = "設定";
+  cjk_corpus->rows = g_ptr_array_new_with_free_func(g_free);
+  for (int i = 0; i < BENCH_SYNTHETIC_ROWS; i++) {
+    GString *str = g_string_new(NULL);
+    int words = g_rand_int_range(rand, 1, 6);
+    for (int w = 0; w < words; w++) {
+      g_string_append(str, bench_pick(rand, cjk, G_N_ELEMENTS(cjk)));
+      if (g_rand_boolean(rand)) {
+        g_string_append_printf(str, " v%d ", w);
+      }
+    }
+    g_ptr_array_add(cjk_corpus->rows, g_string_free(str, FALSE));
+  }
+  g_ptr_array_add(corpora, cjk_corpus);
+
+  // Latin words with combining marks (NFD), e.g. "cafe" + U+0301.
+  BenchCorpus *combining = g_malloc0(sizeof(BenchCorpus));
+  combining->name = g_strdup("combining");
+  combining->query = "cafe";
+  combining->rows = g_ptr_array_new_with_free_func(g_free);
+  for (int i = 0; i < BENCH_SYNTHETIC_ROWS; i++) {
+    GString *str = g_string_new(NULL);
+    int words = g_rand_int_range(rand, 1, 6);
+    for (int w = 0; w < words; w++) {
+      const char *word = bench_pick(rand, latin, G_N_ELEMENTS(latin));
+      for (const char *c = word; *c != '\0'; c++) {
+        g_string_append_c(str, *c);
+        if (g_rand_int_range(rand, 0, 4) == 0) {
+          g_string_append_unichar(str, 0x0300 + g_rand_int_range(rand, 0, 4));
+        }
+      }
+      g_string_append_c(str, ' ');
+    }
+    g_ptr_array_add(combining->rows, g_string_free(str, FALSE));
+  }
+  g_ptr_array_add(corpora, combining);
+  g_rand_free(rand);
+}
+
+/**
+ * @param path The file to load.
+ *
+ * Load a recorded corpus, one row per line.
+ *
+ * @returns the corpus, or NULL on failure.
+ */
+static BenchCorpus *bench_load_corpus(const char *path) {
+  char *contents = NULL;
+  GError *error = NULL;
+  if (!g_file_get_contents(path, &contents, NULL, &error)) {
+    fprintf(stderr, "Failed to load corpus %s: %s\n", path, error->message);
+    g_error_free(error);
+    return NULL;
+  }
+  BenchCorpus *corpus = g_malloc0(sizeof(BenchCorpus));
+  corpus->name = g_path_get_basename(path);
+  char *dot = strrchr(corpus->name, '.');
+  if (dot != NULL) {
+    *dot = '\0';
+  }
+  corpus->query = "fire";
+  corpus->rows = g_ptr_array_new_with_free_func(g_free);
+  char **lines = g_strsplit(contents, "\n", -1);
+  for (int i = 0; lines[i] != NULL; i++) {
+    if (lines[i][0] != '\0') {
+      g_ptr_array_add(corpus->rows, lines[i]);
+    } else {
+      g_free(lines[i]);
+    }
+  }
+  g_free(lines);
+  g_free(contents);
+  return corpus;
+}
+
+static void bench_corpus_free(gpointer data) {
+  BenchCorpus *corpus = (BenchCorpus *)data;
+  g_ptr_array_free(corpus->rows, TRUE);
+  g_free(corpus->name);
+  g_free(corpus);
+}
+
+int main(int argc, char **argv) {
+  if (setlocale(LC_ALL, "") == NULL) {
+    fprintf(stderr, "Failed to set locale.\n");
+    return EXIT_FAILURE;
+  }
+  const char *min_time = g_getenv("ROFI_BENCH_MIN_TIME");
+  if (min_time != NULL) {
+    bench_min_time = (gint64)(g_ascii_strtod(min_time, NULL) * G_USEC_PER_SEC);
+  }
+  GPtrArray *corpora = g_ptr_array_new_with_free_func(bench_corpus_free);
+  bench_synthetic_corpora(corpora);
+  for (int i = 1; i < argc; i++) {
+    BenchCorpus *corpus = bench_load_corpus(argv[i]);
+    if (corpus == NULL) {
+      g_ptr_array_free(corpora, TRUE);
+      return EXIT_FAILURE;
+    }
+    g_ptr_array_add(corpora, corpus);
+  }
+  for (guint i = 0; i < corpora->len; i++) {
+    bench_corpus(g_ptr_array_index(corpora, i));
+  }
+  g_ptr_array_free(corpora, TRUE);
+  return EXIT_SUCCESS;
+}
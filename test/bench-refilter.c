@@ -0,0 +1,496 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * End-to-end benchmark of refiltering the view.
+ *
+ * A view is created on a synthetic mode, without an X11 window (see
+ * rofi_view_create_headless()), and a keystroke script is typed into it. For
+ * each thread count and rows per thread, the time each keystroke spends
+ * filtering, sorting, updating the listview and resizing the window is
+ * printed as one JSON object per line:
+ *
+ * {"threads":4,"rows_per_thread":500,"rows":100000,"fields":2,
+ *  "distribution":"words","step":3,"input":"fir","matches":812,
+ *  "filter_us":1520,"sort_us":35,"listview_us":4,"resize_us":310,
+ *  "total_us":2950}
+ *
+ * Options:
+ *
+ * -bench-rows N: number of rows in the mode (default 100000).
+ * -bench-fields N: number of matchable fields per row (default 2).
+ * -bench-distribution words|paths|cjk: the kind of rows (default words).
+ * -bench-threads 1,2,4: thread counts to run (default powers of two up to
+ *  the number of processors).
+ * -bench-rows-per-thread 250,500: values of -filter-rows-per-thread to run.
+ * -bench-script SCRIPT: keys typed, <bs> is backspace and <clear> clears the
+ *  input (default "firefox<bs><bs><bs><bs>ox<clear>term").
+ * -bench-repeat N: number of times the script is replayed (default 3).
+ *
+ * All other rofi options, like -sort and -matching, apply as well.
+ */
+
+#include "config.h"
+
+#include "display.h"
+#include "helper.h"
+#include "mode-private.h"
+#include "rofi-icon-fetcher.h"
+#include "rofi.h"
+#include "settings.h"
+#include "theme.h"
+#include "view-internal.h"
+#include "view.h"
+#include "xcb-internal.h"
+#include "xcb.h"
+#include "xrmoptions.h"
+#include <glib.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Without an X server, there is no connection to use. The headless view does
+ * not use it.
+ */
+static xcb_stuff xcb_int = {.connection = NULL};
+xcb_stuff *xcb = &xcb_int;
+xcb_depth_t *depth = NULL;
+xcb_visualtype_t *visual = NULL;
+xcb_colormap_t map = XCB_COLORMAP_NONE;
+xcb_atom_t netatoms[NUM_NETATOMS];
+GList *list_of_warning_msgs = NULL;
+const char *cache_dir = NULL;
+gint rofi_timings_trace = FALSE;
+
+void rofi_timings_tick(G_GNUC_UNUSED const char *file,
+                       G_GNUC_UNUSED char const *str, G_GNUC_UNUSED int line,
+                       G_GNUC_UNUSED char const *msg);
+void rofi_timings_tick(G_GNUC_UNUSED const char *file,
+                       G_GNUC_UNUSED char const *str, G_GNUC_UNUSED int line,
+                       G_GNUC_UNUSED char const *msg) {}
+void rofi_timings_trace_begin(G_GNUC_UNUSED const char *name);
+void rofi_timings_trace_begin(G_GNUC_UNUSED const char *name) {}
+void rofi_timings_trace_end(G_GNUC_UNUSED const char *name);
+void rofi_timings_trace_end(G_GNUC_UNUSED const char *name) {}
+uint32_t rofi_icon_fetcher_query(G_GNUC_UNUSED const char *name,
+                                 G_GNUC_UNUSED const int size) {
+  return 0;
+}
+uint32_t rofi_icon_fetcher_query_advanced(G_GNUC_UNUSED const char *name,
+                                          G_GNUC_UNUSED const int wsize,
+                                          G_GNUC_UNUSED const int hsize) {
+  return 0;
+}
+cairo_surface_t *rofi_icon_fetcher_get(G_GNUC_UNUSED const uint32_t uid) {
+  return NULL;
+}
+
+void rofi_add_error_message(G_GNUC_UNUSED GString *msg) {}
+void rofi_add_warning_message(G_GNUC_UNUSED GString *msg) {}
+void rofi_clear_error_messages(void) {}
+void rofi_clear_warning_messages(void) {}
+unsigned int rofi_get_num_enabled_modes(void) { return 0; }
+const Mode *rofi_get_mode(G_GNUC_UNUSED unsigned int index) { return NULL; }
+void rofi_quit_main_loop(void) {}
+void process_result(RofiViewState *state);
+void process_result(G_GNUC_UNUSED RofiViewState *state) {}
+guint key_binding_get_action_from_name(G_GNUC_UNUSED const char *name) {
+  return UINT32_MAX;
+}
+BindingsScope key_binding_get_scope_from_name(G_GNUC_UNUSED const char *name) {
+  return SCOPE_GLOBAL;
+}
+
+int monitor_active(workarea *mon) {
+  memset(mon, 0, sizeof(workarea));
+  mon->w = 1920;
+  mon->h = 1080;
+  return 1;
+}
+void display_startup_notification(
+    G_GNUC_UNUSED RofiHelperExecuteContext *context,
+    G_GNUC_UNUSED GSpawnChildSetupFunc *child_setup,
+    G_GNUC_UNUSED gpointer *user_data) {}
+void display_early_cleanup(void) {}
+void xcb_stuff_set_clipboard(char *data) { g_free(data); }
+xcb_window_t xcb_stuff_get_root_window(void) { return XCB_WINDOW_NONE; }
+void window_set_atom_prop(G_GNUC_UNUSED xcb_window_t w,
+                          G_GNUC_UNUSED xcb_atom_t prop,
+                          G_GNUC_UNUSED xcb_atom_t *atoms,
+                          G_GNUC_UNUSED int count) {}
+void rofi_xcb_set_input_focus(G_GNUC_UNUSED xcb_window_t w) {}
+void rofi_xcb_revert_input_focus(void) {}
+cairo_surface_t *x11_helper_get_bg_surface(void) { return NULL; }
+cairo_surface_t *x11_helper_get_screenshot_surface(void) { return NULL; }
+void x11_disable_decoration(G_GNUC_UNUSED xcb_window_t window) {}
+void x11_set_cursor(G_GNUC_UNUSED xcb_window_t window,
+                    G_GNUC_UNUSED X11CursorType type) {}
+void cairo_image_surface_blur(G_GNUC_UNUSED cairo_surface_t *surface,
+                              G_GNUC_UNUSED double radius,
+                              G_GNUC_UNUSED double deviation) {}
+#ifdef XCB_IMDKIT
+void x11_event_handler_fowarding(G_GNUC_UNUSED xcb_xim_t *im,
+                                 G_GNUC_UNUSED xcb_xic_t ic,
+                                 G_GNUC_UNUSED xcb_key_press_event_t *event,
+                                 G_GNUC_UNUSED void *user_data) {}
+#endif
+
+/**
+ * The rows of the synthetic mode.
+ */
+typedef struct {
+  /** Holds the strings of the rows. */
+  RofiStringArena *arena;
+  /** The matchable fields of each row, followed by the displayed text. */
+  RofiColumnStore *store;
+  /** The columns of store, it does not change after it is filled. */
+  const ModeColumn *columns;
+  /** Number of matchable fields. */
+  unsigned int num_fields;
+} BenchModePrivateData;
+
+static unsigned int bench_mode_get_num_entries(const Mode *sw) {
+  const BenchModePrivateData *pd =
+      (const BenchModePrivateData *)mode_get_private_data(sw);
+  return helper_column_store_get_num_rows(pd->store);
+}
+
+/**
+ * @param sw The synthetic mode.
+ * @param index The row.
+ *
+ * @returns the displayed text of the row.
+ */
+static const char *bench_mode_get_text(const Mode *sw, unsigned int index) {
+  const BenchModePrivateData *pd =
+      (const BenchModePrivateData *)mode_get_private_data(sw);
+  const ModeColumn *text = &(pd->columns[pd->num_fields]);
+  return text->strings[index];
+}
+
+static int bench_mode_token_match(const Mode *sw, rofi_int_matcher **tokens,
+                                  unsigned int index) {
+  return helper_token_match(tokens, bench_mode_get_text(sw, index));
+}
+
+static char *bench_mode_get_display_value(const Mode *sw, unsigned int index,
+                                          G_GNUC_UNUSED int *state,
+                                          G_GNUC_UNUSED GList **attr_list,
+                                          int get_entry) {
+  return get_entry ? g_strdup(bench_mode_get_text(sw, index)) : NULL;
+}
+
+static const char *bench_mode_peek_completion(const Mode *sw,
+                                              unsigned int index) {
+  return bench_mode_get_text(sw, index);
+}
+
+static gboolean bench_mode_get_columns(const Mode *sw, ModeColumns *columns) {
+  const BenchModePrivateData *pd =
+      (const BenchModePrivateData *)mode_get_private_data(sw);
+  columns->num_rows = helper_column_store_get_num_rows(pd->store);
+  columns->num_columns = pd->num_fields;
+  columns->columns = pd->columns;
+  columns->completion = pd->columns[pd->num_fields];
+  columns->index = NULL;
+  return TRUE;
+}
+
+/** The synthetic mode. */
+static Mode bench_mode = {.name = "bench",
+                          .display_name = "bench",
+                          ._get_num_entries = bench_mode_get_num_entries,
+                          ._token_match = bench_mode_token_match,
+                          ._get_display_value = bench_mode_get_display_value,
+                          ._peek_completion = bench_mode_peek_completion,
+                          ._get_columns = bench_mode_get_columns,
+                          .type = MODE_TYPE_SWITCHER};
+
+/**
+ * @param rand Random generator.
+ * @param distribution Kind of text to generate.
+ * @param str String to append to.
+ *
+ * Append one random field.
+ */
+static void bench_field(GRand *rand, const char *distribution, GString *str) {
+  static const char *const words[] = {
+      "firefox", "terminal", "settings", "files",   "editor",  "office",
+      "mail",    "calendar", "music",    "player",  "network", "manager",
+      "system",  "monitor",  "image",    "viewer",  "text",    "document",
+      "browser", "chat",     "game",     "archive", "backup",  "disk",
+      "printer", "camera",   "video",    "sound",   "console", "develop"};
+  static const char *const dirs[] = {"usr",   "lib",   "share", "local",
+                                     "bin",   "home",  "user",  "src",
+                                     "build", "icons", "etc",   "var"};
+  static const char *const cjk[] = {"東京", "大阪", "日本語", "入力",
+                                    "文件", "设置", "终端",   "浏览器",
+                                    "파일", "설정", "ファイル", "テキスト"};
+  int n = g_rand_int_range(rand, 1, 5);
+  for (int i = 0; i < n; i++) {
+    if (g_strcmp0(distribution, "paths") == 0) {
+      g_string_append_printf(str, "/%s",
+                             dirs[g_rand_int_range(rand, 0,
+                                                   G_N_ELEMENTS(dirs))]);
+    } else if (g_strcmp0(distribution, "cjk") == 0) {
+      g_string_append(str, cjk[g_rand_int_range(rand, 0, G_N_ELEMENTS(cjk))]);
+    } else {
+      g_string_append_printf(
+          str, "%s%s", i > 0 ? " " : "",
+          words[g_rand_int_range(rand, 0, G_N_ELEMENTS(words))]);
+    }
+  }
+  g_string_append_printf(str, "%s%u", g_strcmp0(distribution, "paths") ? " "
+                                                                       : "/",
+                         g_rand_int_range(rand, 0, 10000));
+}
+
+/**
+ * @param pd The private data to fill.
+ * @param rows Number of rows.
+ * @param distribution Kind of text to generate.
+ *
+ * Generate the rows, with a fixed seed so runs compare.
+ */
+static void bench_mode_fill(BenchModePrivateData *pd, unsigned int rows,
+                            const char *distribution) {
+  GRand *rand = g_rand_new_with_seed(42);
+  GString *field = g_string_new(NULL);
+  GString *text = g_string_new(NULL);
+  pd->arena = helper_string_arena_new();
+  pd->store = helper_column_store_new(pd->num_fields + 1);
+  for (unsigned int i = 0; i < rows; i++) {
+    unsigned int row = helper_column_store_add_row(pd->store);
+    g_string_truncate(text, 0);
+    for (unsigned int f = 0; f < pd->num_fields; f++) {
+      g_string_truncate(field, 0);
+      bench_field(rand, distribution, field);
+      helper_column_store_set(
+          pd->store, row, f,
+          helper_string_arena_add(pd->arena, field->str, field->len),
+          field->len);
+      if (f > 0) {
+        g_string_append_c(text, '\t');
+      }
+      g_string_append_len(text, field->str, field->len);
+    }
+    helper_column_store_set(
+        pd->store, row, pd->num_fields,
+        helper_string_arena_add(pd->arena, text->str, text->len), text->len);
+  }
+  pd->columns = helper_column_store_get_columns(pd->store);
+  g_string_free(text, TRUE);
+  g_string_free(field, TRUE);
+  g_rand_free(rand);
+}
+
+/**
+ * @param key The option.
+ * @param def Value if the option is not given.
+ *
+ * @returns the comma separated numbers given with key, free with g_array_free.
+ */
+static GArray *bench_arg_uint_list(const char *key, const char *def) {
+  char *str = NULL;
+  if (find_arg_str(key, &str) == FALSE) {
+    str = (char *)def;
+  }
+  GArray *values = g_array_new(FALSE, FALSE, sizeof(unsigned int));
+  char **items = g_strsplit(str, ",", 0);
+  for (int i = 0; items[i] != NULL; i++) {
+    unsigned int value = (unsigned int)g_ascii_strtoull(items[i], NULL, 10);
+    if (value > 0) {
+      g_array_append_val(values, value);
+    }
+  }
+  g_strfreev(items);
+  return values;
+}
+
+/**
+ * @param str The string to print.
+ *
+ * Print str as JSON string.
+ */
+static void bench_print_json_string(const char *str) {
+  putchar('"');
+  for (const char *p = str; *p != '\0'; p++) {
+    if (*p == '"' || *p == '\\') {
+      printf("\\%c", *p);
+    } else if ((unsigned char)*p < 0x20) {
+      printf("\\u%04x", (unsigned char)*p);
+    } else {
+      putchar(*p);
+    }
+  }
+  putchar('"');
+}
+
+/**
+ * @param state The view.
+ * @param key The key to type.
+ *
+ * Type one key of the script and wait for the refilter to complete.
+ */
+static void bench_type_key(RofiViewState *state, const char *key) {
+  if (g_strcmp0(key, "<bs>") == 0) {
+    rofi_view_trigger_action(state, SCOPE_GLOBAL, REMOVE_CHAR_BACK);
+  } else if (g_strcmp0(key, "<clear>") == 0) {
+    rofi_view_trigger_action(state, SCOPE_GLOBAL, CLEAR_LINE);
+  } else {
+    rofi_view_handle_text(state, (char *)key);
+  }
+  rofi_view_maybe_update(state);
+  // Passes that continue in the background are completed here.
+  rofi_view_filter_finish();
+}
+
+/**
+ * @param script The keystroke script.
+ *
+ * Split the script in keys, one character or a <name> each.
+ *
+ * @returns the keys, free with g_strfreev.
+ */
+static char **bench_script_keys(const char *script) {
+  GPtrArray *keys = g_ptr_array_new();
+  const char *p = script;
+  while (*p != '\0') {
+    const char *end = NULL;
+    if (*p == '<' && (end = strchr(p, '>')) != NULL) {
+      end++;
+    } else {
+      end = g_utf8_next_char(p);
+    }
+    g_ptr_array_add(keys, g_strndup(p, end - p));
+    p = end;
+  }
+  g_ptr_array_add(keys, NULL);
+  return (char **)g_ptr_array_free(keys, FALSE);
+}
+
+int main(int argc, char **argv) {
+  if (setlocale(LC_ALL, "") == NULL) {
+    fprintf(stderr, "Failed to set locale.\n");
+    return EXIT_FAILURE;
+  }
+  cmd_set_arguments(argc, argv);
+  rofi_theme_parse_string("@theme \"default\"");
+  config_parse_cmd_options();
+  rofi_theme_parse_process_conditionals();
+  rofi_theme_parse_process_links();
+
+  unsigned int rows = 100000;
+  unsigned int fields = 2;
+  unsigned int repeat = 3;
+  char *distribution = "words";
+  char *script = "firefox<bs><bs><bs><bs>ox<clear>term";
+  find_arg_uint("-bench-rows", &rows);
+  find_arg_uint("-bench-fields", &fields);
+  find_arg_uint("-bench-repeat", &repeat);
+  find_arg_str("-bench-distribution", &distribution);
+  find_arg_str("-bench-script", &script);
+  fields = MAX(1, fields);
+
+  GString *def_threads = g_string_new("1");
+  long procs = sysconf(_SC_NPROCESSORS_ONLN);
+  for (long t = 2; t <= procs; t *= 2) {
+    g_string_append_printf(def_threads, ",%ld", t);
+  }
+  GArray *threads = bench_arg_uint_list("-bench-threads", def_threads->str);
+  g_string_free(def_threads, TRUE);
+  char *def_rpt = g_strdup_printf("%u", config.filter_rows_per_thread);
+  GArray *rows_per_thread = bench_arg_uint_list("-bench-rows-per-thread",
+                                                def_rpt);
+  g_free(def_rpt);
+
+  BenchModePrivateData pd = {.num_fields = fields};
+  bench_mode_fill(&pd, rows, distribution);
+  mode_set_private_data(&bench_mode, &pd);
+
+  textbox_setup();
+  rofi_view_create_headless(MENU_NORMAL, 1920, 1080);
+  char **keys = bench_script_keys(script);
+
+  for (guint t = 0; t < threads->len; t++) {
+    config.threads = g_array_index(threads, unsigned int, t);
+    rofi_view_workers_initialize();
+    for (guint r = 0; r < rows_per_thread->len; r++) {
+      config.filter_rows_per_thread =
+          g_array_index(rows_per_thread, unsigned int, r);
+      RofiViewState *state =
+          rofi_view_create(&bench_mode, "", MENU_NORMAL, NULL);
+      rofi_view_set_active(state);
+      unsigned int step = 0;
+      for (unsigned int i = 0; i < repeat; i++) {
+        for (unsigned int k = 0; keys[k] != NULL; k++) {
+          gint64 start = g_get_monotonic_time();
+          bench_type_key(state, keys[k]);
+          gint64 total = g_get_monotonic_time() - start;
+          printf("{\"threads\":%u,\"rows_per_thread\":%u,\"rows\":%u,"
+                 "\"fields\":%u,\"distribution\":\"%s\",\"step\":%u,"
+                 "\"input\":",
+                 config.threads, config.filter_rows_per_thread, rows, fields,
+                 distribution, step++);
+          bench_print_json_string(state->text->text);
+          printf(",\"matches\":%u,"
+                 "\"filter_us\":%" G_GINT64_FORMAT
+                 ",\"sort_us\":%" G_GINT64_FORMAT
+                 ",\"listview_us\":%" G_GINT64_FORMAT
+                 ",\"resize_us\":%" G_GINT64_FORMAT
+                 ",\"total_us\":%" G_GINT64_FORMAT "}\n",
+                 state->filtered_lines, state->filter_timings.filter,
+                 state->filter_timings.sort, state->filter_timings.listview,
+                 state->filter_timings.resize, total);
+          // Draws queued by the view are not part of the keystroke.
+          while (g_main_context_iteration(NULL, FALSE)) {
+          }
+        }
+        if (state->text->text[0] != '\0') {
+          bench_type_key(state, "<clear>");
+          while (g_main_context_iteration(NULL, FALSE)) {
+          }
+        }
+      }
+      rofi_view_set_active(NULL);
+      rofi_view_free(state);
+    }
+    rofi_view_workers_finalize();
+  }
+  fflush(stdout);
+
+  g_strfreev(keys);
+  g_array_free(threads, TRUE);
+  g_array_free(rows_per_thread, TRUE);
+  mode_set_private_data(&bench_mode, NULL);
+  helper_column_store_free(pd.store);
+  helper_string_arena_free(pd.arena);
+  return EXIT_SUCCESS;
+}
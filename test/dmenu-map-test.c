@@ -0,0 +1,240 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Reading a mapped -input file with a separator other than a newline.
+ *
+ * The rows point into the read only mapping and are not terminated. The file
+ * fills exactly one page, so reading past the last row, which has no
+ * separator, runs off the mapping.
+ */
+
+#include "config.h"
+
+#include "display.h"
+#include "helper.h"
+#include "mode-private.h"
+#include "mode.h"
+#include "rofi-icon-fetcher.h"
+#include "rofi.h"
+#include "settings.h"
+#include "theme.h"
+#include "view.h"
+#include "xcb-internal.h"
+#include "xcb.h"
+#include "xrmoptions.h"
+#include <assert.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <limits.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+unsigned int test = 0;
+#define TASSERT(a)                                                             \
+  {                                                                            \
+    assert(a);                                                                 \
+    printf("Test %3u passed (%s)\n", ++test, #a);                              \
+  }
+
+/**
+ * Without an X server, there is no connection to use. The headless view does
+ * not use it.
+ */
+static xcb_stuff xcb_int = {.connection = NULL};
+xcb_stuff *xcb = &xcb_int;
+xcb_depth_t *depth = NULL;
+xcb_visualtype_t *visual = NULL;
+xcb_colormap_t map = XCB_COLORMAP_NONE;
+xcb_atom_t netatoms[NUM_NETATOMS];
+GList *list_of_warning_msgs = NULL;
+const char *cache_dir = NULL;
+gint rofi_timings_trace = FALSE;
+
+void rofi_timings_tick(G_GNUC_UNUSED const char *file,
+                       G_GNUC_UNUSED char const *str, G_GNUC_UNUSED int line,
+                       G_GNUC_UNUSED char const *msg);
+void rofi_timings_tick(G_GNUC_UNUSED const char *file,
+                       G_GNUC_UNUSED char const *str, G_GNUC_UNUSED int line,
+                       G_GNUC_UNUSED char const *msg) {}
+void rofi_timings_trace_begin(G_GNUC_UNUSED const char *name);
+void rofi_timings_trace_begin(G_GNUC_UNUSED const char *name) {}
+void rofi_timings_trace_end(G_GNUC_UNUSED const char *name);
+void rofi_timings_trace_end(G_GNUC_UNUSED const char *name) {}
+uint32_t rofi_icon_fetcher_query(G_GNUC_UNUSED const char *name,
+                                 G_GNUC_UNUSED const int size) {
+  return 0;
+}
+uint32_t rofi_icon_fetcher_query_advanced(G_GNUC_UNUSED const char *name,
+                                          G_GNUC_UNUSED const int wsize,
+                                          G_GNUC_UNUSED const int hsize) {
+  return 0;
+}
+cairo_surface_t *rofi_icon_fetcher_get(G_GNUC_UNUSED const uint32_t uid) {
+  return NULL;
+}
+
+void rofi_add_error_message(G_GNUC_UNUSED GString *msg) {}
+void rofi_add_warning_message(G_GNUC_UNUSED GString *msg) {}
+void rofi_clear_error_messages(void) {}
+void rofi_clear_warning_messages(void) {}
+unsigned int rofi_get_num_enabled_modes(void) { return 0; }
+const Mode *rofi_get_mode(G_GNUC_UNUSED unsigned int index) { return NULL; }
+void rofi_quit_main_loop(void) {}
+void process_result(RofiViewState *state);
+void process_result(G_GNUC_UNUSED RofiViewState *state) {}
+guint key_binding_get_action_from_name(G_GNUC_UNUSED const char *name) {
+  return UINT32_MAX;
+}
+BindingsScope key_binding_get_scope_from_name(G_GNUC_UNUSED const char *name) {
+  return SCOPE_GLOBAL;
+}
+
+int monitor_active(workarea *mon) {
+  memset(mon, 0, sizeof(workarea));
+  mon->w = 1920;
+  mon->h = 1080;
+  return 1;
+}
+void display_startup_notification(
+    G_GNUC_UNUSED RofiHelperExecuteContext *context,
+    G_GNUC_UNUSED GSpawnChildSetupFunc *child_setup,
+    G_GNUC_UNUSED gpointer *user_data) {}
+void display_early_cleanup(void) {}
+void xcb_stuff_set_clipboard(char *data) { g_free(data); }
+xcb_window_t xcb_stuff_get_root_window(void) { return XCB_WINDOW_NONE; }
+void window_set_atom_prop(G_GNUC_UNUSED xcb_window_t w,
+                          G_GNUC_UNUSED xcb_atom_t prop,
+                          G_GNUC_UNUSED xcb_atom_t *atoms,
+                          G_GNUC_UNUSED int count) {}
+void rofi_xcb_set_input_focus(G_GNUC_UNUSED xcb_window_t w) {}
+void rofi_xcb_revert_input_focus(void) {}
+cairo_surface_t *x11_helper_get_bg_surface(void) { return NULL; }
+cairo_surface_t *x11_helper_get_screenshot_surface(void) { return NULL; }
+void x11_disable_decoration(G_GNUC_UNUSED xcb_window_t window) {}
+void x11_set_cursor(G_GNUC_UNUSED xcb_window_t window,
+                    G_GNUC_UNUSED X11CursorType type) {}
+void cairo_image_surface_blur(G_GNUC_UNUSED cairo_surface_t *surface,
+                              G_GNUC_UNUSED double radius,
+                              G_GNUC_UNUSED double deviation) {}
+#ifdef XCB_IMDKIT
+void x11_event_handler_fowarding(G_GNUC_UNUSED xcb_xim_t *im,
+                                 G_GNUC_UNUSED xcb_xic_t ic,
+                                 G_GNUC_UNUSED xcb_key_press_event_t *event,
+                                 G_GNUC_UNUSED void *user_data) {}
+#endif
+
+void rofi_set_return_code(G_GNUC_UNUSED int code) {}
+
+/** The dmenu mode, see source/modes/dmenu.c. */
+extern Mode dmenu_mode;
+
+/**
+ * @param row The row.
+ * @param expected The text the row should display.
+ *
+ * @returns TRUE if the row displays expected.
+ */
+static gboolean test_display(unsigned int row, const char *expected) {
+  int state = 0;
+  char *str = mode_get_display_value(&dmenu_mode, row, &state, NULL, TRUE);
+  gboolean retv = g_strcmp0(str, expected) == 0;
+  g_free(str);
+  return retv;
+}
+
+/**
+ * @param input The user input.
+ * @param expected The only row expected to match input.
+ *
+ * @returns TRUE if only row expected matches input.
+ */
+static gboolean test_match(const char *input, unsigned int expected) {
+  rofi_int_matcher **tokens = helper_tokenize(input, config.case_sensitive);
+  gboolean retv = TRUE;
+  for (unsigned int i = 0; i < mode_get_num_entries(&dmenu_mode); i++) {
+    int match = mode_token_match(&dmenu_mode, tokens, i);
+    retv = retv && (match == (i == expected));
+  }
+  helper_tokenize_free(tokens);
+  return retv;
+}
+
+int main(G_GNUC_UNUSED int argc, char **argv) {
+  if (setlocale(LC_ALL, "") == NULL) {
+    fprintf(stderr, "Failed to set locale.\n");
+    return EXIT_FAILURE;
+  }
+  // The first row pads the file to a page, the third has optional fields and
+  // the last has no separator.
+  const char tail[] = "|two\nlines|beta\0meta\x1fgreek|omega";
+  gsize page = sysconf(_SC_PAGESIZE);
+  gsize pad = page - (sizeof(tail) - 1);
+  GString *first = g_string_new("alpha ");
+  while (first->len < pad) {
+    g_string_append_c(first, 'x');
+  }
+  GString *data = g_string_new_len(first->str, first->len);
+  g_string_append_len(data, tail, sizeof(tail) - 1);
+  TASSERT(data->len == page);
+
+  char *path = NULL;
+  int fd = g_file_open_tmp("rofi-dmenu-map-XXXXXX", &path, NULL);
+  TASSERT(fd != -1);
+  TASSERT(write(fd, data->str, data->len) == (ssize_t)data->len);
+  close(fd);
+
+  char *args[] = {argv[0], "-input", path, "-sep", "|", NULL};
+  cmd_set_arguments(5, args);
+  config.threads = 1;
+  TASSERT(mode_init(&dmenu_mode));
+  TASSERT(mode_get_num_entries(&dmenu_mode) == 4);
+  TASSERT(test_display(0, first->str));
+  TASSERT(test_display(1, "two\nlines"));
+  TASSERT(test_display(2, "beta"));
+  TASSERT(test_display(3, "omega"));
+  char *completion = mode_get_completion(&dmenu_mode, 3);
+  TASSERT(g_strcmp0(completion, "omega") == 0);
+  g_free(completion);
+
+  TASSERT(test_match("alpha", 0));
+  TASSERT(test_match("lines", 1));
+  TASSERT(test_match("greek", 2));
+  TASSERT(test_match("omega", 3));
+  // The match stops at the end of the row.
+  TASSERT(test_match("alpha two", UINT_MAX));
+
+  mode_destroy(&dmenu_mode);
+  g_unlink(path);
+  g_free(path);
+  g_string_free(data, TRUE);
+  g_string_free(first, TRUE);
+  return EXIT_SUCCESS;
+}
@@ -36,6 +36,7 @@
 #include "xcb.h"
 #include <assert.h>
 #include <glib.h>
+#include <limits.h>
 #include <helper.h>
 #include <locale.h>
 #include <stdio.h>
@@ -162,6 +163,25 @@ int main(int argc, char **argv) {
   TASSERTE(levenshtein("otp", g_utf8_strlen("otp", -1), "noot aap",
                        g_utf8_strlen("noot aap", -1)),
            5u);
+  {
+    // Needles longer than one 64 bit word.
+    char *ln = g_strnfill(100, 'a');
+    char *lh = g_strconcat(ln, "b", NULL);
+    lh[10] = 'c';
+    TASSERTE(levenshtein(ln, 100, lh, 101), 2u);
+    TASSERTE(levenshtein(lh, 101, ln, 100), 2u);
+    TASSERTE(levenshtein(ln, 100, "aap", 3), 98u);
+    g_free(lh);
+    g_free(ln);
+  }
+  {
+    RofiLevenshteinNeedle *n = levenshtein_needle_new("aap", 3);
+    TASSERTE(levenshtein_needle_distance(n, "noot aap mies", -1, UINT_MAX),
+             10u);
+    TASSERTE(levenshtein_needle_distance(n, "noot aap mies", 13, 4), 5u);
+    TASSERTE(levenshtein_needle_distance(n, "AAP", -1, 4), 0u);
+    levenshtein_needle_free(n);
+  }
   /**
    * Quick converision check.
    */
@@ -204,6 +224,49 @@ int main(int argc, char **argv) {
     TASSERTL(rofi_scorer_fuzzy_evaluate("Anm", 3, "aap noot mies", 12), -155);
     TASSERTL(rofi_scorer_fuzzy_evaluate("aap noot mies", 12, "Anm", 3),
              1073741824);
+    // Input longer than 256 characters is scored, not ranked last.
+    char *lpad = g_strnfill(300, '/');
+    char *lstr = g_strconcat(lpad, "aap noot mies", NULL);
+    TASSERTL(rofi_scorer_fuzzy_evaluate("anm", 3, lstr, 313), 1050);
+    TASSERTL(rofi_scorer_fuzzy_evaluate("blu", 3, lstr, 313), 1073741824);
+    g_free(lstr);
+    g_free(lpad);
+  }
+
+  /**
+   * String arena.
+   */
+  {
+    RofiStringArena *arena = helper_string_arena_new();
+    char *s1 = helper_string_arena_add(arena, "aap noot", 3);
+    char *s2 = helper_string_arena_add(arena, "mies", -1);
+    TASSERT(g_strcmp0(s1, "aap") == 0);
+    TASSERT(g_strcmp0(s2, "mies") == 0);
+    // Invalid UTF-8 is replaced.
+    char *s3 = helper_string_arena_add_utf8(arena,
+                                            "a\xff"
+                                            "b",
+                                            3);
+    TASSERT(g_strcmp0(s3, "a\uFFFDb") == 0);
+    // Large strings do not move the small ones.
+    char *large = g_strnfill(100000, 'x');
+    char *s4 = helper_string_arena_add(arena, large, -1);
+    char *s5 = helper_string_arena_add(arena, "wim", -1);
+    TASSERT(g_strcmp0(s4, large) == 0);
+    TASSERT(g_strcmp0(s5, "wim") == 0);
+    TASSERT(g_strcmp0(s1, "aap") == 0);
+    TASSERT(helper_string_arena_get_size(arena) >= 100001);
+    // Merged strings stay in place.
+    RofiStringArena *other = helper_string_arena_new();
+    char *s6 = helper_string_arena_add(other, "zus", -1);
+    gsize size = helper_string_arena_get_size(arena);
+    helper_string_arena_merge(arena, other);
+    TASSERT(g_strcmp0(s6, "zus") == 0);
+    TASSERT(helper_string_arena_get_size(arena) > size);
+    char *s7 = helper_string_arena_add(arena, "jet", -1);
+    TASSERT(g_strcmp0(s7, "jet") == 0);
+    g_free(large);
+    helper_string_arena_free(arena);
   }
 
   char *a;
@@ -26,6 +26,7 @@
  */
 
 #include "display.h"
+#include "helper-theme.h"
 #include "rofi-icon-fetcher.h"
 #include "rofi-types.h"
 #include "rofi.h"
@@ -154,6 +155,255 @@ START_TEST(test_tokenizer_match_normal_multiple_ci_negate) {
 }
 END_TEST
 
+START_TEST(test_tokenizer_match_normal_unicode) {
+  config.matching_method = MM_NORMAL;
+  rofi_int_matcher **tokens = helper_tokenize("éö", FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap éö mies"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap ÉÖ mies"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap eo mies"), FALSE);
+  helper_tokenize_free(tokens);
+
+  tokens = helper_tokenize("éö", TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap éö mies"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap ÉÖ mies"), FALSE);
+  helper_tokenize_free(tokens);
+}
+END_TEST
+
+START_TEST(test_tokenizer_match_normal_normalize_cached) {
+  config.matching_method = MM_NORMAL;
+  config.normalize_match = TRUE;
+  config.case_sensitive = FALSE;
+  rofi_int_matcher **tokens = helper_tokenize("aéo", FALSE);
+  RofiHaystackCache *cache = helper_haystack_cache_new(1);
+  helper_haystack_cache_resize(cache, 3);
+  // Twice, to check both the filling and the cached path.
+  for (int i = 0; i < 2; i++) {
+    ck_assert_int_eq(
+        helper_token_match_cached(tokens, cache, 0, 0, "xàeöx", -1), TRUE);
+    ck_assert_int_eq(
+        helper_token_match_cached(tokens, cache, 1, 0, "ÀÉÖ", -1), TRUE);
+    ck_assert_int_eq(
+        helper_token_match_cached(tokens, cache, 2, 0, "àeu", -1), FALSE);
+  }
+  helper_haystack_cache_free(cache);
+  helper_tokenize_free(tokens);
+  config.normalize_match = FALSE;
+}
+END_TEST
+
+/** Shared state of the threads in test_tokenizer_match_cached_threads. */
+typedef struct {
+  rofi_int_matcher **tokens;
+  RofiHaystackCache *cache;
+  char **rows;
+  unsigned int num_rows;
+} CachedMatchTest;
+
+static gpointer cached_match_thread(gpointer data) {
+  CachedMatchTest *t = data;
+  unsigned int matches = 0;
+  for (unsigned int i = 0; i < t->num_rows; i++) {
+    matches += helper_token_match_cached(t->tokens, t->cache, i, 0,
+                                         t->rows[i], -1);
+  }
+  return GUINT_TO_POINTER(matches);
+}
+
+START_TEST(test_tokenizer_match_cached_threads) {
+  config.matching_method = MM_NORMAL;
+  config.normalize_match = TRUE;
+  config.case_sensitive = FALSE;
+  CachedMatchTest t = {.tokens = helper_tokenize("aéo", FALSE),
+                       .cache = helper_haystack_cache_new(1),
+                       .num_rows = 5000};
+  t.rows = g_new0(char *, t.num_rows + 1);
+  for (unsigned int i = 0; i < t.num_rows; i++) {
+    t.rows[i] = g_strdup_printf("%u %s", i, (i % 2) ? "ÀÉÖ" : "àeu");
+  }
+  helper_haystack_cache_resize(t.cache, t.num_rows);
+  // All threads prepare the same rows at the same time.
+  GThread *threads[4];
+  for (unsigned int i = 0; i < G_N_ELEMENTS(threads); i++) {
+    threads[i] = g_thread_new("match", cached_match_thread, &t);
+  }
+  for (unsigned int i = 0; i < G_N_ELEMENTS(threads); i++) {
+    ck_assert_int_eq(GPOINTER_TO_UINT(g_thread_join(threads[i])),
+                     t.num_rows / 2);
+  }
+  helper_haystack_cache_free(t.cache);
+  helper_tokenize_free(t.tokens);
+  g_strfreev(t.rows);
+  config.normalize_match = FALSE;
+}
+END_TEST
+
+START_TEST(test_tokenizer_match_normal_columns) {
+  config.matching_method = MM_NORMAL;
+  RofiColumnStore *store = helper_column_store_new(2);
+  unsigned int row = helper_column_store_add_row(store);
+  helper_column_store_set(store, row, 0, "Firefox", -1);
+  helper_column_store_set(store, row, 1, "Web Browser", -1);
+  row = helper_column_store_add_row(store);
+  helper_column_store_set(store, row, 1, "Text editor xx", 11);
+  row = helper_column_store_add_row(store);
+  ModeColumns columns = {.num_rows = helper_column_store_get_num_rows(store),
+                         .num_columns = 2,
+                         .columns = helper_column_store_get_columns(store)};
+  ck_assert_int_eq(columns.num_rows, 3);
+
+  rofi_int_matcher **tokens = helper_tokenize("fire web", FALSE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 0), TRUE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 1), FALSE);
+  helper_tokenize_free(tokens);
+  tokens = helper_tokenize("edit", FALSE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 0), FALSE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 1), TRUE);
+  helper_tokenize_free(tokens);
+  tokens = helper_tokenize("xx", FALSE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 1), FALSE);
+  helper_tokenize_free(tokens);
+  // Inverted tokens match if no column matches, also on an empty row.
+  tokens = helper_tokenize("-fire", FALSE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 0), FALSE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 1), TRUE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 2), TRUE);
+  helper_tokenize_free(tokens);
+  helper_column_store_free(store);
+}
+END_TEST
+
+/**
+ * @param tokens The tokens.
+ * @param fields The fields of the row, NULL if missing.
+ * @param num_fields Number of fields.
+ *
+ * Match a row field by field, like drun_token_match() does.
+ *
+ * @returns TRUE if the row matches.
+ */
+static int match_fields(rofi_int_matcher **tokens, const char *const *fields,
+                        unsigned int num_fields) {
+  for (int j = 0; tokens[j] != NULL; j++) {
+    rofi_int_matcher *ftokens[2] = {tokens[j], NULL};
+    int test = tokens[j]->invert;
+    for (unsigned int f = 0; f < num_fields; f++) {
+      if (test == tokens[j]->invert && fields[f] != NULL) {
+        test = helper_token_match(ftokens, fields[f]);
+      }
+    }
+    if (test == 0) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+START_TEST(test_tokenizer_match_columns_like_fields) {
+  config.matching_method = MM_NORMAL;
+  // Rows of drun with the name field (the first) disabled or missing.
+  const char *const rows[][3] = {{"Firefox", "Web Browser", "firefox"},
+                                 {NULL, "Web Browser", "firefox"},
+                                 {NULL, "Text Editor", "gedit"},
+                                 {NULL, NULL, NULL}};
+  RofiColumnStore *store = helper_column_store_new(3);
+  for (unsigned int r = 0; r < G_N_ELEMENTS(rows); r++) {
+    unsigned int row = helper_column_store_add_row(store);
+    for (unsigned int c = 0; c < 3; c++) {
+      helper_column_store_set(store, row, c, rows[r][c], -1);
+    }
+  }
+  ModeColumns columns = {.num_rows = G_N_ELEMENTS(rows),
+                         .num_columns = 3,
+                         .columns = helper_column_store_get_columns(store)};
+  const char *queries[] = {"fire", "-fire", "-edit", "web -gedit", "-xx"};
+  for (unsigned int q = 0; q < G_N_ELEMENTS(queries); q++) {
+    rofi_int_matcher **tokens = helper_tokenize(queries[q], FALSE);
+    for (unsigned int r = 0; r < G_N_ELEMENTS(rows); r++) {
+      ck_assert_int_eq(helper_token_match_columns(tokens, &columns, r),
+                       match_fields(tokens, rows[r], 3));
+    }
+    helper_tokenize_free(tokens);
+  }
+  rofi_int_matcher **tokens = helper_tokenize("-edit", FALSE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 1), TRUE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 2), FALSE);
+  helper_tokenize_free(tokens);
+  helper_column_store_free(store);
+}
+END_TEST
+
+START_TEST(test_tokenizer_match_normal_length) {
+  config.matching_method = MM_NORMAL;
+  // Only the first 11 bytes are part of the row.
+  const char *const strings[] = {"Text editor xx"};
+  const unsigned int lengths[] = {11};
+  ModeColumn column = {strings, lengths};
+  ModeColumns columns = {.num_rows = 1, .num_columns = 1, .columns = &column};
+  rofi_int_matcher **tokens = helper_tokenize("xx", TRUE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 0), FALSE);
+  helper_tokenize_free(tokens);
+  tokens = helper_tokenize("editor", TRUE);
+  ck_assert_int_eq(helper_token_match_columns(tokens, &columns, 0), TRUE);
+  helper_tokenize_free(tokens);
+}
+END_TEST
+
+START_TEST(test_tokenizer_match_normal_spans) {
+  config.matching_method = MM_NORMAL;
+  rofi_int_matcher **tokens = helper_tokenize("noot -mies", FALSE);
+  GArray *spans = helper_token_match_get_spans(tokens, "aap Noot noot");
+  ck_assert_int_eq(spans->len, 2);
+  ck_assert_int_eq(g_array_index(spans, RofiMatchSpan, 0).start, 4);
+  ck_assert_int_eq(g_array_index(spans, RofiMatchSpan, 0).end, 8);
+  ck_assert_int_eq(g_array_index(spans, RofiMatchSpan, 1).start, 9);
+  ck_assert_int_eq(g_array_index(spans, RofiMatchSpan, 1).end, 13);
+  g_array_free(spans, TRUE);
+  spans = helper_token_match_get_spans(tokens, "aap mies");
+  ck_assert_int_eq(spans->len, 0);
+  g_array_free(spans, TRUE);
+  helper_tokenize_free(tokens);
+}
+END_TEST
+
+START_TEST(test_tokenizer_match_normal_trigram_index) {
+  config.matching_method = MM_NORMAL;
+  RofiTrigramIndex *index = helper_trigram_index_new(1024 * 1024);
+  helper_trigram_index_add(index, 0, "Aap noot", -1);
+  helper_trigram_index_add(index, 1, "mies", -1);
+  helper_trigram_index_add(index, 1, "NOOT", -1);
+  helper_trigram_index_add(index, 2, "Wim zus", -1);
+  helper_trigram_index_add(index, 3, "\xe2\x84\xaa"
+                                     "ees",
+                           -1);
+
+  unsigned int length = 0;
+  rofi_int_matcher **tokens = helper_tokenize("noot", FALSE);
+  unsigned int *rows = helper_trigram_index_query(index, tokens, 4, &length);
+  // Row 3 has non-ASCII text that can fold to ASCII.
+  ck_assert_ptr_nonnull(rows);
+  ck_assert_int_eq(length, 3);
+  ck_assert_int_eq(rows[0], 0);
+  ck_assert_int_eq(rows[1], 1);
+  ck_assert_int_eq(rows[2], 3);
+  g_free(rows);
+  helper_tokenize_free(tokens);
+
+  tokens = helper_tokenize("noot zus", TRUE);
+  rows = helper_trigram_index_query(index, tokens, 4, &length);
+  ck_assert_ptr_nonnull(rows);
+  ck_assert_int_eq(length, 0);
+  g_free(rows);
+  helper_tokenize_free(tokens);
+
+  // Short and inverted tokens can not be looked up.
+  tokens = helper_tokenize("no -wim", FALSE);
+  ck_assert_ptr_null(helper_trigram_index_query(index, tokens, 4, &length));
+  helper_tokenize_free(tokens);
+  helper_trigram_index_free(index);
+}
+END_TEST
+
 START_TEST(test_tokenizer_match_glob_single_ci) {
   config.matching_method = MM_GLOB;
   rofi_int_matcher **tokens = helper_tokenize("noot", FALSE);
@@ -234,6 +484,38 @@ START_TEST(test_tokenizer_match_glob_multiple_ci_star) {
 }
 END_TEST
 
+START_TEST(test_tokenizer_match_glob_question_space) {
+  config.matching_method = MM_GLOB;
+  rofi_int_matcher **tokens = helper_tokenize("p?n*t", FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap noot mies"), FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap-noot mies"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "APXNOOT"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "apXnoo"), FALSE);
+  helper_tokenize_free(tokens);
+}
+END_TEST
+
+START_TEST(test_tokenizer_match_glob_non_ascii_ci) {
+  config.matching_method = MM_GLOB;
+  rofi_int_matcher **tokens = helper_tokenize("École", FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "une école"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "une ÉCOLE"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "une ecole"), FALSE);
+  helper_tokenize_free(tokens);
+
+  // The Kelvin sign folds to an ASCII k.
+  tokens = helper_tokenize("k*n", FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "x \u212Aelvin"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "x \u212Aelvi"), FALSE);
+  helper_tokenize_free(tokens);
+
+  tokens = helper_tokenize("*É", FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap é"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap e"), FALSE);
+  helper_tokenize_free(tokens);
+}
+END_TEST
+
 START_TEST(test_tokenizer_match_fuzzy_single_ci) {
   config.matching_method = MM_FUZZY;
   rofi_int_matcher **tokens = helper_tokenize("noot", FALSE);
@@ -309,6 +591,31 @@ START_TEST(test_tokenizer_match_fuzzy_multiple_ci_split) {
 }
 END_TEST
 
+START_TEST(test_tokenizer_match_prefix_single_ci) {
+  config.matching_method = MM_PREFIX;
+  rofi_int_matcher **tokens = helper_tokenize("noo", FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap noot mies"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap mies"), FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "aapnoot mies"), FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap_noot mies"), FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap-Noot mies"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "nootap mies"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "aapnoo noot"), TRUE);
+  helper_tokenize_free(tokens);
+}
+END_TEST
+
+START_TEST(test_tokenizer_match_prefix_multiple_cs) {
+  config.matching_method = MM_PREFIX;
+  rofi_int_matcher **tokens = helper_tokenize("no mi", TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap noot mies"), TRUE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap Noot mies"), FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "aap noot ami"), FALSE);
+  ck_assert_int_eq(helper_token_match(tokens, "mies.noot"), TRUE);
+  helper_tokenize_free(tokens);
+}
+END_TEST
+
 START_TEST(test_tokenizer_match_regex_single_ci) {
   config.matching_method = MM_REGEX;
   rofi_int_matcher **tokens = helper_tokenize("noot", FALSE);
@@ -409,6 +716,14 @@ static Suite *helper_tokenizer_suite(void) {
     tcase_add_test(tc_normal, test_tokenizer_match_normal_multiple_ci);
     tcase_add_test(tc_normal, test_tokenizer_match_normal_single_ci_negate);
     tcase_add_test(tc_normal, test_tokenizer_match_normal_multiple_ci_negate);
+    tcase_add_test(tc_normal, test_tokenizer_match_normal_unicode);
+    tcase_add_test(tc_normal, test_tokenizer_match_normal_normalize_cached);
+    tcase_add_test(tc_normal, test_tokenizer_match_cached_threads);
+    tcase_add_test(tc_normal, test_tokenizer_match_normal_columns);
+    tcase_add_test(tc_normal, test_tokenizer_match_columns_like_fields);
+    tcase_add_test(tc_normal, test_tokenizer_match_normal_length);
+    tcase_add_test(tc_normal, test_tokenizer_match_normal_spans);
+    tcase_add_test(tc_normal, test_tokenizer_match_normal_trigram_index);
     suite_add_tcase(s, tc_normal);
   }
   {
@@ -419,6 +734,8 @@ static Suite *helper_tokenizer_suite(void) {
     tcase_add_test(tc_glob, test_tokenizer_match_glob_single_ci_question);
     tcase_add_test(tc_glob, test_tokenizer_match_glob_single_ci_star);
     tcase_add_test(tc_glob, test_tokenizer_match_glob_multiple_ci_star);
+    tcase_add_test(tc_glob, test_tokenizer_match_glob_question_space);
+    tcase_add_test(tc_glob, test_tokenizer_match_glob_non_ascii_ci);
     suite_add_tcase(s, tc_glob);
   }
   {
@@ -430,6 +747,12 @@ static Suite *helper_tokenizer_suite(void) {
     tcase_add_test(tc_fuzzy, test_tokenizer_match_fuzzy_multiple_ci_split);
     suite_add_tcase(s, tc_fuzzy);
   }
+  {
+    TCase *tc_prefix = tcase_create("Prefix");
+    tcase_add_test(tc_prefix, test_tokenizer_match_prefix_single_ci);
+    tcase_add_test(tc_prefix, test_tokenizer_match_prefix_multiple_cs);
+    suite_add_tcase(s, tc_prefix);
+  }
   {
     TCase *tc_regex = tcase_create("Regex");
     tcase_add_test(tc_regex, test_tokenizer_match_regex_single_ci);
@@ -0,0 +1,307 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/**
+ * Reloading the rows of the view while a filter pass runs in the background.
+ *
+ * The workers of the pass are held back, so the pass is still running while
+ * the view draws the previous result with the new number of rows.
+ */
+
+#include "config.h"
+
+#include "display.h"
+#include "helper.h"
+#include "mode-private.h"
+#include "rofi-icon-fetcher.h"
+#include "rofi.h"
+#include "settings.h"
+#include "theme.h"
+#include "view-internal.h"
+#include "view.h"
+#include "xcb-internal.h"
+#include "xcb.h"
+#include "xrmoptions.h"
+#include <assert.h>
+#include <glib.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+unsigned int test = 0;
+#define TASSERT(a)                                                             \
+  {                                                                            \
+    assert(a);                                                                 \
+    printf("Test %3u passed (%s)\n", ++test, #a);                              \
+  }
+
+/**
+ * Without an X server, there is no connection to use. The headless view does
+ * not use it.
+ */
+static xcb_stuff xcb_int = {.connection = NULL};
+xcb_stuff *xcb = &xcb_int;
+xcb_depth_t *depth = NULL;
+xcb_visualtype_t *visual = NULL;
+xcb_colormap_t map = XCB_COLORMAP_NONE;
+xcb_atom_t netatoms[NUM_NETATOMS];
+GList *list_of_warning_msgs = NULL;
+const char *cache_dir = NULL;
+gint rofi_timings_trace = FALSE;
+
+void rofi_timings_tick(G_GNUC_UNUSED const char *file,
+                       G_GNUC_UNUSED char const *str, G_GNUC_UNUSED int line,
+                       G_GNUC_UNUSED char const *msg);
+void rofi_timings_tick(G_GNUC_UNUSED const char *file,
+                       G_GNUC_UNUSED char const *str, G_GNUC_UNUSED int line,
+                       G_GNUC_UNUSED char const *msg) {}
+void rofi_timings_trace_begin(G_GNUC_UNUSED const char *name);
+void rofi_timings_trace_begin(G_GNUC_UNUSED const char *name) {}
+void rofi_timings_trace_end(G_GNUC_UNUSED const char *name);
+void rofi_timings_trace_end(G_GNUC_UNUSED const char *name) {}
+uint32_t rofi_icon_fetcher_query(G_GNUC_UNUSED const char *name,
+                                 G_GNUC_UNUSED const int size) {
+  return 0;
+}
+uint32_t rofi_icon_fetcher_query_advanced(G_GNUC_UNUSED const char *name,
+                                          G_GNUC_UNUSED const int wsize,
+                                          G_GNUC_UNUSED const int hsize) {
+  return 0;
+}
+cairo_surface_t *rofi_icon_fetcher_get(G_GNUC_UNUSED const uint32_t uid) {
+  return NULL;
+}
+
+void rofi_add_error_message(G_GNUC_UNUSED GString *msg) {}
+void rofi_add_warning_message(G_GNUC_UNUSED GString *msg) {}
+void rofi_clear_error_messages(void) {}
+void rofi_clear_warning_messages(void) {}
+unsigned int rofi_get_num_enabled_modes(void) { return 0; }
+const Mode *rofi_get_mode(G_GNUC_UNUSED unsigned int index) { return NULL; }
+void rofi_quit_main_loop(void) {}
+void process_result(RofiViewState *state);
+void process_result(G_GNUC_UNUSED RofiViewState *state) {}
+guint key_binding_get_action_from_name(G_GNUC_UNUSED const char *name) {
+  return UINT32_MAX;
+}
+BindingsScope key_binding_get_scope_from_name(G_GNUC_UNUSED const char *name) {
+  return SCOPE_GLOBAL;
+}
+
+int monitor_active(workarea *mon) {
+  memset(mon, 0, sizeof(workarea));
+  mon->w = 1920;
+  mon->h = 1080;
+  return 1;
+}
+void display_startup_notification(
+    G_GNUC_UNUSED RofiHelperExecuteContext *context,
+    G_GNUC_UNUSED GSpawnChildSetupFunc *child_setup,
+    G_GNUC_UNUSED gpointer *user_data) {}
+void display_early_cleanup(void) {}
+void xcb_stuff_set_clipboard(char *data) { g_free(data); }
+xcb_window_t xcb_stuff_get_root_window(void) { return XCB_WINDOW_NONE; }
+void window_set_atom_prop(G_GNUC_UNUSED xcb_window_t w,
+                          G_GNUC_UNUSED xcb_atom_t prop,
+                          G_GNUC_UNUSED xcb_atom_t *atoms,
+                          G_GNUC_UNUSED int count) {}
+void rofi_xcb_set_input_focus(G_GNUC_UNUSED xcb_window_t w) {}
+void rofi_xcb_revert_input_focus(void) {}
+cairo_surface_t *x11_helper_get_bg_surface(void) { return NULL; }
+cairo_surface_t *x11_helper_get_screenshot_surface(void) { return NULL; }
+void x11_disable_decoration(G_GNUC_UNUSED xcb_window_t window) {}
+void x11_set_cursor(G_GNUC_UNUSED xcb_window_t window,
+                    G_GNUC_UNUSED X11CursorType type) {}
+void cairo_image_surface_blur(G_GNUC_UNUSED cairo_surface_t *surface,
+                              G_GNUC_UNUSED double radius,
+                              G_GNUC_UNUSED double deviation) {}
+#ifdef XCB_IMDKIT
+void x11_event_handler_fowarding(G_GNUC_UNUSED xcb_xim_t *im,
+                                 G_GNUC_UNUSED xcb_xic_t ic,
+                                 G_GNUC_UNUSED xcb_key_press_event_t *event,
+                                 G_GNUC_UNUSED void *user_data) {}
+#endif
+
+/** Rows in the mode before the reload. */
+#define TEST_ROWS 4096
+/** Rows in the mode after the reload. */
+#define TEST_RELOAD_ROWS 1000
+
+/**
+ * The rows of the test mode, the even rows match "alp".
+ */
+typedef struct {
+  /** The rows. */
+  GPtrArray *rows;
+  /** Number of rows the mode reports. */
+  unsigned int num_rows;
+  /** The thread the view runs in. */
+  GThread *main_thread;
+  /** Protects open. */
+  GMutex mutex;
+  /** Signalled when open is set. */
+  GCond cond;
+  /** If matching on workers may continue. */
+  gboolean open;
+} TestModePrivateData;
+
+static unsigned int test_mode_get_num_entries(const Mode *sw) {
+  const TestModePrivateData *pd =
+      (const TestModePrivateData *)mode_get_private_data(sw);
+  return pd->num_rows;
+}
+
+static int test_mode_token_match(const Mode *sw, rofi_int_matcher **tokens,
+                                 unsigned int index) {
+  TestModePrivateData *pd = (TestModePrivateData *)mode_get_private_data(sw);
+  assert(index < pd->num_rows);
+  if (g_thread_self() != pd->main_thread) {
+    g_mutex_lock(&(pd->mutex));
+    while (!pd->open) {
+      g_cond_wait(&(pd->cond), &(pd->mutex));
+    }
+    g_mutex_unlock(&(pd->mutex));
+  } else if (!pd->open) {
+    // Give the workers time to take the other chunks.
+    g_usleep(100);
+  }
+  return helper_token_match(tokens, g_ptr_array_index(pd->rows, index));
+}
+
+static char *test_mode_get_display_value(const Mode *sw, unsigned int index,
+                                         G_GNUC_UNUSED int *state,
+                                         G_GNUC_UNUSED GList **attr_list,
+                                         int get_entry) {
+  const TestModePrivateData *pd =
+      (const TestModePrivateData *)mode_get_private_data(sw);
+  // Drawing a row that went away reads past the rows.
+  assert(index < pd->num_rows);
+  return get_entry ? g_strdup(g_ptr_array_index(pd->rows, index)) : NULL;
+}
+
+/** The test mode. */
+static Mode test_mode = {.name = "test",
+                         .display_name = "test",
+                         ._get_num_entries = test_mode_get_num_entries,
+                         ._token_match = test_mode_token_match,
+                         ._get_display_value = test_mode_get_display_value,
+                         .type = MODE_TYPE_SWITCHER};
+
+/**
+ * @param pd The test mode.
+ * @param open If workers may continue.
+ *
+ * Hold back or release the workers of the filter pass.
+ */
+static void test_mode_set_open(TestModePrivateData *pd, gboolean open) {
+  g_mutex_lock(&(pd->mutex));
+  pd->open = open;
+  g_cond_broadcast(&(pd->cond));
+  g_mutex_unlock(&(pd->mutex));
+}
+
+int main(int argc, char **argv) {
+  if (setlocale(LC_ALL, "") == NULL) {
+    fprintf(stderr, "Failed to set locale.\n");
+    return EXIT_FAILURE;
+  }
+  cmd_set_arguments(argc, argv);
+  rofi_theme_parse_string("@theme \"default\"");
+  config_parse_cmd_options();
+  rofi_theme_parse_process_conditionals();
+  rofi_theme_parse_process_links();
+
+  TestModePrivateData pd = {.rows = g_ptr_array_new_with_free_func(g_free),
+                            .num_rows = TEST_ROWS,
+                            .main_thread = g_thread_self(),
+                            .open = TRUE};
+  g_mutex_init(&(pd.mutex));
+  g_cond_init(&(pd.cond));
+  for (unsigned int i = 0; i < TEST_ROWS; i++) {
+    g_ptr_array_add(pd.rows, g_strdup_printf("%s %u",
+                                             (i % 2) ? "omega" : "alpha", i));
+  }
+  mode_set_private_data(&test_mode, &pd);
+
+  config.threads = 4;
+  config.filter_rows_per_thread = 1;
+  config.refilter_timeout_limit = 1;
+  config.sort = FALSE;
+  textbox_setup();
+  rofi_view_create_headless(MENU_NORMAL, 1920, 1080);
+  rofi_view_workers_initialize();
+  RofiViewState *state = rofi_view_create(&test_mode, "", MENU_NORMAL, NULL);
+  rofi_view_set_active(state);
+
+  rofi_view_handle_text(state, "alp");
+  rofi_view_maybe_update(state);
+  rofi_view_filter_finish();
+  TASSERT(state->filtered_lines == TEST_ROWS / 2);
+
+  // Drop rows and reload, the new pass can not complete.
+  test_mode_set_open(&pd, FALSE);
+  pd.num_rows = TEST_RELOAD_ROWS;
+  rofi_view_reload();
+  while (!state->reload) {
+    g_main_context_iteration(NULL, TRUE);
+  }
+  rofi_view_maybe_update(state);
+  TASSERT(state->filter_job != NULL);
+  TASSERT(state->num_lines == TEST_RELOAD_ROWS);
+  // The previous result is shown, without the rows that went away.
+  TASSERT(state->filtered_lines == TEST_RELOAD_ROWS / 2);
+  TASSERT(state->ranked_lines <= state->filtered_lines);
+  gboolean kept = TRUE;
+  for (unsigned int i = 0; i < state->filtered_lines; i++) {
+    kept = kept && state->line_map[i] == 2 * i;
+  }
+  TASSERT(kept);
+  rofi_view_update(state, TRUE);
+
+  // Let the pass complete in the background.
+  test_mode_set_open(&pd, TRUE);
+  while (state->filter_job != NULL) {
+    g_main_context_iteration(NULL, TRUE);
+  }
+  TASSERT(state->filtered_lines == TEST_RELOAD_ROWS / 2);
+  kept = TRUE;
+  for (unsigned int i = 0; i < state->filtered_lines; i++) {
+    kept = kept && state->line_map[i] == 2 * i;
+  }
+  TASSERT(kept);
+
+  rofi_view_set_active(NULL);
+  rofi_view_free(state);
+  rofi_view_workers_finalize();
+  mode_set_private_data(&test_mode, NULL);
+  g_mutex_clear(&(pd.mutex));
+  g_cond_clear(&(pd.cond));
+  g_ptr_array_free(pd.rows, TRUE);
+  return EXIT_SUCCESS;
+}